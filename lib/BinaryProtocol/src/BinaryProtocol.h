@@ -0,0 +1,184 @@
+#pragma once
+
+#include <Arduino.h>
+
+#ifdef __AVR__
+#include <util/crc16.h>
+#endif
+
+/**
+ * Binary command framing shared by the feeder and the fleet controller.
+ *
+ * On the wire a frame is `0x00 COBS(opcode, sequence, payload..., crc16) 0x00`. COBS removes every
+ * zero byte from the frame, so the delimiters can never be confused with the content and a text
+ * line (which never contains 0x00) can be told apart from a frame by its first byte.
+ * Multi-byte fields are little-endian; the CRC is CRC-16/CCITT-FALSE over opcode..payload.
+ *
+ * Responses echo the request's sequence number and use `opcode | RESPONSE_FLAG`, followed by a status.
+ * Unsolicited log records (see Logger.h) start with `LOG_RECORD | level` instead, input trace
+ * records (see InputTrace.h) with TRACE_RECORD.
+ */
+struct BinaryProtocol {
+    static const uint8_t FRAME_DELIMITER = 0x00;
+    static const uint8_t RESPONSE_FLAG = 0x80;
+    static const uint8_t LOG_RECORD = 0x70;
+    static const uint8_t TRACE_RECORD = 0x60;
+    static const uint8_t HEADER_SIZE = 2;
+    static const uint8_t CRC_SIZE = 2;
+
+    enum Opcode: uint8_t {
+        SET_TIME = 0x01,        // u32 ms of day
+        SCHEDULE_JOB = 0x02,    // u8 hours, u8 minutes, u8 seconds -> u16 job id
+        UNSCHEDULE_JOB = 0x03,  // u16 job id
+        LIST_JOBS = 0x04,       // -> u8 count, count * (u16 id (0 for system jobs), u32 ms of day, u8 flags:
+                                // 1 system job, 2 has a recurrence other than daily)
+        SET_JOB_PROFILE = 0x05, // u16 job id, u8 angle, u16 dwell ms, u8 repeats
+        READ_PROFILE = 0x06,    // u8 section -> u8 sections, u32 calls, u32 total us, u16 max us,
+                                // 12 * u16 histogram; resets the section (profiling builds only)
+        READ_MEMORY = 0x07,     // -> u16 stack never used, u16 free now, u16 free heap, u16 largest
+                                // free block, u8 count, count * u16 sizeof (see memoryFootprint)
+        SET_JOB_RULE = 0x08,    // u16 job id, u8 weekday mask (bit 0 Monday), u16 interval minutes
+                                // (0: once), u16 minute of day of the last repeat
+        SET_WEEKDAY = 0x09,     // u8 day of the week, 0 Monday
+        READ_SERIAL = 0x0A,     // -> u32 lines, u32 frames, u16 lines dropped too long, u16 frames
+                                // dropped too long, all since boot
+        BEGIN_SCHEDULE = 0x0B,  // starts an upload of the whole user schedule (see ScheduleUpload)
+        STAGE_JOB = 0x0C,       // u32 ms of day, u32 packed rule (0: daily), u32 packed profile (0: default)
+        COMMIT_SCHEDULE = 0x0D, // u8 jobs staged -> u8 user jobs, u16 checksum of the schedule
+        EXPORT_STATE = 0x0E,    // u8 first job index, u16 since version (0: all) -> a page of the
+                                // schedule and state (see StateExport)
+        SYNC_TIME = 0x0F,       // u32 host ms of day as sent -> u32 feeder ms of day (see ClockSync)
+        SYNC_ADJUST = 0x10,     // u32 host ms of day as the SYNC_TIME answer arrived -> u16 round
+                                // trip ms, u32 offset ms applied (signed), u32 rate in 0.01 ppm (signed)
+    };
+
+    enum Status: uint8_t {
+        OK = 0x00,
+        BAD_CRC = 0x01,
+        BAD_LENGTH = 0x02,
+        UNKNOWN_OPCODE = 0x03,
+        REJECTED = 0x04,
+    };
+
+    static uint16_t crc16(const uint8_t* data, uint8_t length, uint16_t crc = 0xFFFF) {
+        while (length--) {
+#ifdef __AVR__
+            crc = _crc_xmodem_update(crc, *data++);
+#else
+            crc ^= (uint16_t)(*data++) << 8;
+            for (uint8_t bit = 0; bit < 8; ++bit) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+#endif
+        }
+        return crc;
+    }
+
+    // Decodes a COBS block (without delimiters) in place and returns the decoded length, 0 if malformed.
+    static uint8_t decode(uint8_t* data, uint8_t length) {
+        uint8_t read = 0, written = 0;
+        while (read < length) {
+            const uint8_t code = data[read++];
+            if (!code || read + code - 1 > length) return 0;
+            for (uint8_t i = 1; i < code; ++i) data[written++] = data[read++];
+            if (code != 0xFF && read < length) data[written++] = 0;
+        }
+        return written;
+    }
+
+    // Writes `data` COBS encoded between frame delimiters.
+    static size_t send(Print& output, const uint8_t* data, uint8_t length) {
+        size_t sent = output.write(FRAME_DELIMITER);
+        uint8_t blockStart = 0;
+        while (true) {
+            uint8_t blockEnd = blockStart;
+            while (blockEnd < length && data[blockEnd] && blockEnd - blockStart < 0xFE) ++blockEnd;
+
+            sent += output.write((uint8_t)(blockEnd - blockStart + 1));
+            sent += output.write(data + blockStart, blockEnd - blockStart);
+
+            if (blockEnd == length) break;
+            blockStart = data[blockEnd] ? blockEnd : blockEnd + 1;
+            if (blockStart == length && !data[blockEnd]) {
+                sent += output.write((uint8_t)1);
+                break;
+            }
+        }
+        return sent + output.write(FRAME_DELIMITER);
+    }
+};
+
+/**
+ * Little-endian reads straight out of a decoded frame; nothing is copied.
+ * Reading past the end yields zeros and clears `isValid`.
+ */
+struct FrameReader {
+    FrameReader(const uint8_t* data, uint8_t length): _data{data}, _length{length} {}
+
+    uint8_t remaining() const { return _length - _position; }
+    bool isValid() const { return _isValid; }
+
+    uint8_t u8() {
+        if (!take(1)) return 0;
+        return _data[_position - 1];
+    }
+
+    uint16_t u16() {
+        if (!take(2)) return 0;
+        const auto bytes = _data + _position - 2;
+        return (uint16_t)bytes[0] | (uint16_t)bytes[1] << 8;
+    }
+
+    uint32_t u32() {
+        if (!take(4)) return 0;
+        const auto bytes = _data + _position - 4;
+        return (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+    }
+
+private:
+    const uint8_t* _data;
+    uint8_t _length;
+    uint8_t _position = 0;
+    bool _isValid = true;
+
+    bool take(uint8_t size) {
+        if (remaining() < size) _isValid = false;
+        if (!_isValid) return false;
+        _position += size;
+        return true;
+    }
+};
+
+// Builds a response frame in a fixed buffer; writes beyond CAPACITY are dropped and make `send` fail.
+template<uint8_t CAPACITY>
+struct FrameWriter {
+    FrameWriter(uint8_t opcode, uint8_t sequence, uint8_t status) {
+        u8(opcode | BinaryProtocol::RESPONSE_FLAG);
+        u8(sequence);
+        u8(status);
+    }
+
+    FrameWriter& u8(uint8_t value) {
+        if (_length < CAPACITY - BinaryProtocol::CRC_SIZE) _data[_length++] = value;
+        else _isOverflowed = true;
+        return *this;
+    }
+
+    FrameWriter& u16(uint16_t value) { return u8(value).u8(value >> 8); }
+    FrameWriter& u32(uint32_t value) { return u16(value).u16(value >> 16); }
+
+    void setStatus(uint8_t status) { _data[2] = status; }
+
+    bool send(Print& output) {
+        if (_isOverflowed) return false;
+
+        const auto crc = BinaryProtocol::crc16(_data, _length);
+        _data[_length] = crc;
+        _data[_length + 1] = crc >> 8;
+        BinaryProtocol::send(output, _data, _length + BinaryProtocol::CRC_SIZE);
+        return true;
+    }
+
+private:
+    uint8_t _data[CAPACITY]{};
+    uint8_t _length = 0;
+    bool _isOverflowed = false;
+};
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <Arduino.h>
+#include <BinaryProtocol.h>
+
+/**
+ * Commands are declared once, in a constexpr table kept in flash:
+ *
+ *     struct Commands {
+ *         static constexpr Command<Context> table[] PROGMEM = {
+ *             {"sti", BinaryProtocol::SET_TIME, 1, {Command<Context>::U32}, [](const uint32_t* args, CommandResponse* response, Context& context) -> uint8_t { ... }},
+ *         };
+ *     };
+ *
+ * The same entry serves the text form (`sti,27000000`) and the binary frame with its opcode; argument
+ * types give both the accepted decimal range and the little-endian width in a frame. Handlers get
+ * a response to fill only for frames and return a BinaryProtocol::Status. Opcode 0 marks a text-only command.
+ */
+
+static const uint8_t COMMAND_MAX_NAME_LENGTH = 7;
+static const uint8_t COMMAND_MAX_ARGS = 4;
+// The longest payload a command answers with; a firmware with longer replies defines it before
+// including this.
+#ifndef COMMAND_MAX_PAYLOAD
+#define COMMAND_MAX_PAYLOAD 64
+#endif
+static_assert(3 + COMMAND_MAX_PAYLOAD + BinaryProtocol::CRC_SIZE <= 0xFF,
+              "a command response must fit a byte-sized frame buffer; lower COMMAND_MAX_PAYLOAD");
+// header, the payload and the CRC
+static const uint8_t COMMAND_RESPONSE_SIZE = 3 + COMMAND_MAX_PAYLOAD + BinaryProtocol::CRC_SIZE;
+typedef FrameWriter<COMMAND_RESPONSE_SIZE> CommandResponse;
+
+template<typename TContext>
+struct Command {
+    enum ArgType: uint8_t { U8, U16, U32 };
+
+    char name[COMMAND_MAX_NAME_LENGTH + 1];
+    uint8_t opcode;
+    uint8_t arity;
+    ArgType types[COMMAND_MAX_ARGS];
+    uint8_t (*handler)(const uint32_t* args, CommandResponse* response, TContext& context);
+
+    static constexpr uint32_t maxOf(ArgType type) { return type == U8 ? 0xFF : type == U16 ? 0xFFFF : 0xFFFFFFFF; }
+    static constexpr uint8_t sizeOf(ArgType type) { return type == U8 ? 1 : type == U16 ? 2 : 4; }
+};
+
+// A view into the input line; nothing is copied or terminated.
+struct Token {
+    const char* begin = nullptr;
+    uint8_t length = 0;
+
+    // Strict decimal: digits only, at most `max`.
+    bool toUnsigned(uint32_t max, uint32_t& value) const {
+        if (!length) return false;
+
+        uint32_t result = 0;
+        for (uint8_t i = 0; i < length; ++i) {
+            const uint8_t digit = begin[i] - '0';
+            if (digit > 9 || result > (max - digit) / 10) return false;
+            result = result * 10 + digit;
+        }
+        value = result;
+        return true;
+    }
+};
+
+struct Tokenizer {
+    explicit Tokenizer(const char* input, char separator = ','): _next{input}, _separator{separator} {}
+
+    bool next(Token& token) {
+        if (!_next) return false;
+
+        token.begin = _next;
+        while (*_next && *_next != _separator) ++_next;
+        token.length = _next - token.begin;
+        _next = *_next ? _next + 1 : nullptr;
+        return true;
+    }
+
+private:
+    const char* _next;
+    const char _separator;
+};
+
+/**
+ * Perfect hash over the names in `TCommands::table`, found while compiling: a multiplier is
+ * searched until every name lands in its own slot, so a lookup is one hash, one slot read and one
+ * name comparison however many commands there are.
+ */
+template<typename TCommands>
+struct CommandMatcher {
+    static const uint8_t EMPTY = 0xFF;
+    static constexpr uint8_t COUNT = sizeof(TCommands::table) / sizeof(TCommands::table[0]);
+
+    static constexpr uint8_t slotBitsFor(uint8_t count) {
+        uint8_t bits = 1;
+        while ((1U << bits) < 2U * count) ++bits;
+        return bits;
+    }
+
+    static constexpr uint8_t SLOT_BITS = slotBitsFor(COUNT);
+    static constexpr uint8_t SLOT_COUNT = 1U << SLOT_BITS;
+
+    static constexpr uint8_t hash(const char* name, uint8_t length, uint16_t seed) {
+        uint16_t value = length;
+        for (uint8_t i = 0; i < length; ++i) value = (uint16_t)((value + (uint8_t)name[i]) * seed);
+        return value >> (16 - SLOT_BITS);
+    }
+
+    static constexpr uint8_t lengthOf(const char* name) {
+        uint8_t length = 0;
+        while (name[length]) ++length;
+        return length;
+    }
+
+    struct Slots {
+        uint16_t seed;
+        uint8_t index[SLOT_COUNT];
+    };
+
+    static constexpr Slots build() {
+        for (uint16_t seed = 3; seed < 0xFFFF; seed += 2) {
+            Slots slots{seed, {}};
+            for (auto& slot : slots.index) slot = EMPTY;
+
+            bool isPerfect = true;
+            for (uint8_t i = 0; i < COUNT && isPerfect; ++i) {
+                const auto& name = TCommands::table[i].name;
+                auto& slot = slots.index[hash(name, lengthOf(name), seed)];
+                if (slot != EMPTY) isPerfect = false;
+                slot = i;
+            }
+            if (isPerfect) return slots;
+        }
+        return Slots{0, {}};
+    }
+
+    static constexpr Slots SLOTS PROGMEM = build();
+    static_assert(SLOTS.seed, "no perfect hash for these command names");
+    static_assert(COUNT < EMPTY, "too many commands");
+
+    static int8_t find(const Token& name) {
+        if (name.length > COMMAND_MAX_NAME_LENGTH) return -1;
+
+        const uint8_t index = pgm_read_byte(&SLOTS.index[hash(name.begin, name.length, SLOTS.seed)]);
+        if (index == EMPTY) return -1;
+
+        const auto candidate = TCommands::table[index].name;
+        if (strncmp_P(name.begin, candidate, name.length) || pgm_read_byte(&candidate[name.length])) return -1;
+        return index;
+    }
+
+    static int8_t findOpcode(uint8_t opcode) {
+        if (!opcode) return -1;
+        for (uint8_t i = 0; i < COUNT; ++i) {
+            if (pgm_read_byte(&TCommands::table[i].opcode) == opcode) return i;
+        }
+        return -1;
+    }
+};
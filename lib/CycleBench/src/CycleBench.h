@@ -0,0 +1,95 @@
+#pragma once
+
+#include <Arduino.h>
+#include <avr/sleep.h>
+
+/**
+ * Exact CPU cycles of code running on the AVR, meant for a simulator such as simavr, which keeps
+ * the timers in step with the instructions (see scripts/avr_bench.sh).
+ *
+ * Timer3 counts every clock, no prescaler. Each run of a body happens with interrupts off, the
+ * counter cleared right before it and read right after; what clearing and reading cost is measured
+ * once on an empty body and taken off. A run that reaches 65536 cycles sets the overflow flag and
+ * is reported as OVERFLOWED rather than wrapped. Runs are repeated, each after an optional
+ * `prepare` that is not counted, and the least, mean and most cycles go out on Serial1, the UART
+ * a simulator prints, one line per benchmark:
+ *
+ *     cycles <name> <least> <mean> <most>
+ *
+ * and `done` at the end. Timer1 stays the Servo library's; millis() keeps running between runs.
+ */
+
+#ifndef AVR_BENCH
+#define AVR_BENCH 0
+#endif
+
+struct CycleBench {
+    static const uint16_t OVERFLOWED = 0xFFFF;
+
+    // Keeps `value` from being optimised away, and what computes it from moving out of the run.
+    template<typename T> static void keep(const T& value) { asm volatile("" : : "r"(&value) : "memory"); }
+
+    static void begin(unsigned long baud = 115200) {
+        Serial1.begin(baud);
+        TCCR3A = 0;
+        TCCR3B = _BV(CS30);
+        _overhead = 0;
+        _overhead = cycles([] {});
+    }
+
+    template<typename TBody>
+    static void run(const __FlashStringHelper* name, uint8_t runs, TBody body) {
+        run(name, runs, [] {}, body);
+    }
+
+    template<typename TPrepare, typename TBody>
+    static void run(const __FlashStringHelper* name, uint8_t runs, TPrepare prepare, TBody body) {
+        uint16_t least = OVERFLOWED, most = 0;
+        uint32_t total = 0;
+        for (uint8_t i = 0; i < runs; ++i) {
+            prepare();
+            const auto taken = cycles(body);
+            if (taken < least) least = taken;
+            if (taken > most) most = taken;
+            total += taken;
+        }
+
+        Serial1.print(F("cycles "));
+        Serial1.print(name);
+        Serial1.print(' ');
+        Serial1.print(least);
+        Serial1.print(' ');
+        Serial1.print(most == OVERFLOWED ? OVERFLOWED : total / runs);
+        Serial1.print(' ');
+        Serial1.println(most);
+    }
+
+    // Says the results are all out and stops the CPU, which ends a simulation.
+    static void end() {
+        Serial1.println(F("done"));
+        Serial1.flush();
+        cli();
+        set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+        sleep_enable();
+        sleep_cpu();
+    }
+
+private:
+    static inline uint16_t _overhead = 0;
+
+    template<typename TBody>
+    static uint16_t cycles(TBody body) {
+        const uint8_t sreg = SREG;
+        cli();
+        TIFR3 = _BV(TOV3);
+        TCNT3 = 0;
+        asm volatile("" : : : "memory");
+        body();
+        asm volatile("" : : : "memory");
+        const uint16_t taken = TCNT3;
+        const bool isOverflowed = TIFR3 & _BV(TOV3);
+        SREG = sreg;
+        if (isOverflowed) return OVERFLOWED;
+        return taken > _overhead ? taken - _overhead : 0;
+    }
+};
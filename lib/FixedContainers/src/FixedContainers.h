@@ -0,0 +1,299 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * Fixed-capacity containers: storage inline, sized at compile time, no heap and no virtual calls.
+ * Sizes and positions are kept in the smallest unsigned type that counts to the capacity, a byte
+ * up to 255 elements. Elements are held by value and copied by assignment, so they are meant to be
+ * small and trivially copyable: bytes, pointers, little structs. Accessors do not check bounds;
+ * the callers do, against size().
+ *
+ *  - InlineVector: an array that grows and shrinks at its end; insertAt/removeAt shift the rest
+ *  - SortedSet: an InlineVector kept ordered by TOrder, with binary search, and no two elements
+ *    equivalent under it
+ *  - RingBuffer: first in, first out, indexed from the oldest element; tail()/commit() and
+ *    span()/pop() let bulk reads and scans work on its storage directly
+ *  - IntrusiveList: a doubly linked list through a Link the elements derive from; the list owns
+ *    no storage, unlinks in O(1), and an element is in one list at a time
+ */
+
+template<bool FITS_BYTE> struct FixedIndex { typedef uint8_t Type; };
+template<> struct FixedIndex<false> { typedef uint16_t Type; };
+
+// The smallest unsigned type holding 0..CAPACITY.
+template<uint16_t CAPACITY> using IndexFor = typename FixedIndex<CAPACITY <= 0xFF>::Type;
+
+template<typename T> struct Less {
+    static constexpr bool less(const T& a, const T& b) { return a < b; }
+};
+
+template<typename T, uint16_t CAPACITY>
+struct InlineVector {
+    typedef IndexFor<CAPACITY> Index;
+
+    static_assert(CAPACITY, "a vector holds at least one element");
+
+    static constexpr Index capacity() { return CAPACITY; }
+    constexpr Index size() const { return _size; }
+    constexpr bool isEmpty() const { return !_size; }
+    constexpr bool isFull() const { return _size == CAPACITY; }
+
+    constexpr bool add(const T& item) {
+        if (isFull()) return false;
+        _items[_size++] = item;
+        return true;
+    }
+
+    // All of `count` items or, when they do not fit, none.
+    constexpr bool append(const T* items, Index count) {
+        if (count > CAPACITY - _size) return false;
+        for (Index i = 0; i < count; ++i) _items[_size++] = items[i];
+        return true;
+    }
+
+    constexpr bool insertAt(Index index, const T& item) {
+        if (isFull() || index > _size) return false;
+        for (Index i = _size; i > index; --i) _items[i] = _items[i - 1];
+        _items[index] = item;
+        _size++;
+        return true;
+    }
+
+    constexpr bool removeAt(Index index) {
+        if (index >= _size) return false;
+        _size--;
+        for (Index i = index; i < _size; ++i) _items[i] = _items[i + 1];
+        return true;
+    }
+
+    // Position of the first element equal to `item`, size() if there is none.
+    constexpr Index indexOf(const T& item) const {
+        Index i = 0;
+        while (i < _size && !(_items[i] == item)) ++i;
+        return i;
+    }
+
+    constexpr void clear() { _size = 0; }
+
+    constexpr T& operator[](Index index) { return _items[index]; }
+    constexpr const T& operator[](Index index) const { return _items[index]; }
+    constexpr T& back() { return _items[_size - 1]; }
+
+    constexpr T* data() { return _items; }
+    constexpr const T* data() const { return _items; }
+
+    constexpr T* begin() { return _items; }
+    constexpr T* end() { return _items + _size; }
+    constexpr const T* begin() const { return _items; }
+    constexpr const T* end() const { return _items + _size; }
+
+private:
+    T _items[CAPACITY]{};
+    Index _size = 0;
+};
+
+// TOrder provides `static bool less(const T&, const T&)`; elements neither less than the other are
+// the same element as far as the set is concerned.
+template<typename T, uint16_t CAPACITY, typename TOrder = Less<T>>
+struct SortedSet {
+    typedef IndexFor<CAPACITY> Index;
+
+    static constexpr Index capacity() { return CAPACITY; }
+    constexpr Index size() const { return _items.size(); }
+    constexpr bool isEmpty() const { return _items.isEmpty(); }
+    constexpr bool isFull() const { return _items.isFull(); }
+
+    // False when the set is full or already holds an equivalent element.
+    constexpr bool add(const T& item) {
+        const auto index = lowerBound(item);
+        if (index < size() && !TOrder::less(item, _items[index])) return false;
+        return _items.insertAt(index, item);
+    }
+
+    // Position of the element equivalent to `item`, size() if there is none.
+    constexpr Index indexOf(const T& item) const {
+        const auto index = lowerBound(item);
+        return index < size() && !TOrder::less(item, _items[index]) ? index : size();
+    }
+
+    constexpr bool contains(const T& item) const { return indexOf(item) < size(); }
+    constexpr bool remove(const T& item) { return _items.removeAt(indexOf(item)); }
+    constexpr bool removeAt(Index index) { return _items.removeAt(index); }
+    constexpr void clear() { _items.clear(); }
+
+    // Position of the first element not less than `item`.
+    constexpr Index lowerBound(const T& item) const {
+        Index low = 0, high = size();
+        while (low < high) {
+            const Index middle = low + (high - low) / 2;
+            if (TOrder::less(_items[middle], item)) low = middle + 1;
+            else high = middle;
+        }
+        return low;
+    }
+
+    // Read only: changing an element in place could break the order.
+    constexpr const T& operator[](Index index) const { return _items[index]; }
+    constexpr const T* begin() const { return _items.begin(); }
+    constexpr const T* end() const { return _items.end(); }
+
+private:
+    InlineVector<T, CAPACITY> _items;
+};
+
+template<typename T, uint16_t CAPACITY>
+struct RingBuffer {
+    typedef IndexFor<CAPACITY> Index;
+
+    static_assert(CAPACITY && CAPACITY <= 0x8000, "a ring holds at least one element, its indices fit 16 bits twice");
+
+    // Walks the slots themselves, wrapping once at the end, and stops by count.
+    struct Iterator {
+        const T* items;
+        Index slot;
+        Index left;
+
+        constexpr const T& operator*() const { return items[slot]; }
+        constexpr Iterator& operator++() {
+            if (++slot == CAPACITY) slot = 0;
+            --left;
+            return *this;
+        }
+        constexpr bool operator!=(const Iterator& other) const { return left != other.left; }
+    };
+
+    static constexpr Index capacity() { return CAPACITY; }
+    constexpr Index size() const { return _used; }
+    constexpr Index space() const { return CAPACITY - _used; }
+    constexpr bool isEmpty() const { return !_used; }
+    constexpr bool isFull() const { return _used == CAPACITY; }
+
+    // Appends after the newest element; false when full.
+    constexpr bool push(const T& item) {
+        if (isFull()) return false;
+        _items[wrap(_head + _used)] = item;
+        _used++;
+        return true;
+    }
+
+    // Drops the `count` oldest elements, all of them if there are fewer.
+    constexpr void pop(Index count = 1) {
+        if (count > _used) count = _used;
+        _head = wrap(_head + count);
+        _used -= count;
+    }
+
+    constexpr void clear() { _head = _used = 0; }
+
+    // The free slots after the newest element, as far as they run without wrapping, for filling in
+    // place (a bulk read) and taking in with commit(). An empty ring starts over at the first slot.
+    constexpr T* tail(Index& length) {
+        if (!_used) _head = 0;
+        const Index slot = wrap(_head + _used);
+        length = isFull() ? 0 : slot >= _head ? CAPACITY - slot : _head - slot;
+        return _items + slot;
+    }
+
+    // Takes in `count` elements written through tail().
+    constexpr void commit(Index count) { _used += count; }
+
+    // The oldest elements as far as they run without wrapping, to be read in place and then dropped
+    // with pop().
+    constexpr const T* span(Index& length) const {
+        length = _head + _used > CAPACITY ? CAPACITY - _head : _used;
+        return _items + _head;
+    }
+
+    constexpr T& front() { return _items[_head]; }
+    constexpr const T& front() const { return _items[_head]; }
+
+    // The element `offset` places after the oldest.
+    constexpr T& operator[](Index offset) { return _items[wrap(_head + offset)]; }
+    constexpr const T& operator[](Index offset) const { return _items[wrap(_head + offset)]; }
+
+    constexpr Iterator begin() const { return Iterator{_items, _head, _used}; }
+    constexpr Iterator end() const { return Iterator{_items, 0, 0}; }
+
+private:
+    T _items[CAPACITY]{};
+    Index _head = 0;
+    Index _used = 0;
+
+    // `index` below 2 * CAPACITY back into the ring: a mask for powers of two, a subtraction
+    // otherwise, never a division
+    static constexpr Index wrap(uint16_t index) {
+        return (CAPACITY & (CAPACITY - 1)) == 0 ? index & (CAPACITY - 1) : index >= CAPACITY ? index - CAPACITY : index;
+    }
+};
+
+// T derives from IntrusiveList<T>::Link.
+template<typename T>
+struct IntrusiveList {
+    struct Link {
+        T* next = nullptr;
+        T* prev = nullptr;
+    };
+
+    struct Iterator {
+        T* item;
+
+        constexpr T& operator*() const { return *item; }
+        constexpr Iterator& operator++() {
+            item = static_cast<Link*>(item)->next;
+            return *this;
+        }
+        constexpr bool operator!=(const Iterator& other) const { return item != other.item; }
+    };
+
+    IntrusiveList() = default;
+    IntrusiveList(const IntrusiveList&) = delete;
+    IntrusiveList& operator=(const IntrusiveList&) = delete;
+
+    constexpr bool isEmpty() const { return !_first; }
+    constexpr T* first() const { return _first; }
+    constexpr T* last() const { return _last; }
+
+    constexpr bool contains(const T& item) const { return link(item).prev || _first == &item; }
+
+    // False if `item` is already in this list.
+    constexpr bool pushFront(T& item) {
+        if (contains(item)) return false;
+        link(item).next = _first;
+        if (_first) link(*_first).prev = &item;
+        else _last = &item;
+        _first = &item;
+        return true;
+    }
+
+    constexpr bool pushBack(T& item) {
+        if (contains(item)) return false;
+        link(item).prev = _last;
+        if (_last) link(*_last).next = &item;
+        else _first = &item;
+        _last = &item;
+        return true;
+    }
+
+    // Unlinks `item`, which must be in this list or in none.
+    constexpr bool remove(T& item) {
+        if (!contains(item)) return false;
+        auto& itemLink = link(item);
+        if (itemLink.prev) link(*itemLink.prev).next = itemLink.next;
+        else _first = itemLink.next;
+        if (itemLink.next) link(*itemLink.next).prev = itemLink.prev;
+        else _last = itemLink.prev;
+        itemLink = Link{};
+        return true;
+    }
+
+    constexpr Iterator begin() const { return Iterator{_first}; }
+    constexpr Iterator end() const { return Iterator{nullptr}; }
+
+private:
+    T* _first = nullptr;
+    T* _last = nullptr;
+
+    static constexpr Link& link(T& item) { return static_cast<Link&>(item); }
+    static constexpr const Link& link(const T& item) { return static_cast<const Link&>(item); }
+};
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * Text formatting into buffers the caller provides: no heap, no printf, nothing kept between calls.
+ *
+ * A format is text with `{}` placeholders, each taking the next argument. Between the braces an
+ * optional spec:
+ *  - a width: `{5}` pads to 5 characters with spaces on the left, `{05}` with zeros
+ *  - `x`: hexadecimal, lower case; `{04x}` has at least 4 digits
+ *  - `.N`: fixed point, the integer argument counting units of 10^-N; `{.2}` of 1234 is 12.34
+ *  - `t`: ms since midnight as HH:MM:SS
+ * Integers are written signed or unsigned as their type is; a string takes a width and nothing else.
+ *
+ * `Format::isValid(format, arguments)` parses a format at compile time. FORMAT and the LOG_* macros
+ * static_assert it, so a spec this does not know, a brace left open or a number of arguments other
+ * than the placeholders fails the build. Output stops at the end of the buffer, which is always
+ * terminated; the result tells how much was written and whether anything was cut.
+ */
+struct Format {
+    enum Kind: uint8_t { DECIMAL_DIGITS, HEX_DIGITS, FIXED_POINT, TIME_OF_DAY };
+
+    static const uint8_t MAX_WIDTH = 20;
+    static const uint8_t MAX_DECIMALS = 9;
+
+    struct Spec {
+        Kind kind = DECIMAL_DIGITS;
+        uint8_t width = 0;
+        bool isZeroPadded = false;
+        uint8_t decimals = 0;
+    };
+
+    struct Result {
+        uint8_t length;
+        bool isTruncated;
+    };
+
+    struct Writer {
+        char* buffer;
+        uint8_t size;
+        uint8_t length = 0;
+        bool isTruncated = false;
+
+        Writer(char* buffer, uint8_t size): buffer{buffer}, size{size} { if (size) buffer[0] = '\0'; }
+
+        void put(char value) {
+            if (length + 1 < size) {
+                buffer[length++] = value;
+                buffer[length] = '\0';
+            } else isTruncated = true;
+        }
+
+        void put(char value, uint8_t count) { while (count--) put(value); }
+
+        void text(const char* value, uint8_t width = 0) {
+            const auto valueLength = strlen(value);
+            if (width > valueLength) put(' ', width - valueLength);
+            while (*value) put(*value++);
+        }
+
+        Result result() const { return Result{length, isTruncated}; }
+    };
+
+    // Reads the spec after a '{'; returns where the text goes on past the '}', nullptr when the
+    // spec is not one of the above.
+    static constexpr const char* parseSpec(const char* at, Spec& spec) {
+        spec = Spec{};
+        if (*at == '0') {
+            spec.isZeroPadded = true;
+            ++at;
+        }
+        while (*at >= '0' && *at <= '9') {
+            spec.width = spec.width * 10 + (*at++ - '0');
+            if (spec.width > MAX_WIDTH) return nullptr;
+        }
+        if (spec.isZeroPadded && !spec.width) return nullptr;
+
+        if (*at == 'x') {
+            spec.kind = HEX_DIGITS;
+            ++at;
+        } else if (*at == 't') {
+            spec.kind = TIME_OF_DAY;
+            ++at;
+        } else if (*at == '.') {
+            spec.kind = FIXED_POINT;
+            ++at;
+            if (*at < '1' || *at > '0' + MAX_DECIMALS) return nullptr;
+            spec.decimals = *at++ - '0';
+        }
+        return *at == '}' ? at + 1 : nullptr;
+    }
+
+    // Placeholders in `format`, -1 if one of them is not valid.
+    static constexpr int16_t placeholders(const char* format) {
+        int16_t count = 0;
+        while (*format) {
+            if (*format++ != '{') continue;
+            Spec spec;
+            format = parseSpec(format, spec);
+            if (!format) return -1;
+            count++;
+        }
+        return count;
+    }
+
+    static constexpr bool isValid(const char* format, uint8_t arguments) { return placeholders(format) == arguments; }
+
+    // IS_VALID is how FORMAT passes on its compile-time check.
+    template<bool IS_VALID = true, typename... TArgs>
+    static Result into(char* buffer, uint8_t size, const char* format, const TArgs&... args) {
+        static_assert(IS_VALID, "the format does not match its arguments");
+        Writer writer{buffer, size};
+        next(writer, format, args...);
+        return writer.result();
+    }
+
+    // One argument as `spec` has it.
+    template<typename T>
+    static void argument(Writer& writer, const Spec& spec, T value) {
+        static_assert(sizeof(T) <= 8 && T(0) < T(1), "only integers, characters and strings are formatted");
+        if constexpr (T(-1) < T(0)) {
+            if (value < 0) return number(writer, spec, 0 - (uint32_t)value, true);
+        }
+        number(writer, spec, (uint32_t)value, false);
+    }
+
+    static void argument(Writer& writer, const Spec& spec, bool value) { number(writer, spec, value, false); }
+    static void argument(Writer& writer, const Spec& spec, char value) {
+        const char text[] = {value, '\0'};
+        writer.text(text, spec.width);
+    }
+    static void argument(Writer& writer, const Spec& spec, const char* value) { writer.text(value, spec.width); }
+    static void argument(Writer& writer, const Spec& spec, char* value) { writer.text(value, spec.width); }
+
+    static void number(Writer& writer, const Spec& spec, uint32_t magnitude, bool isNegative) {
+        // written backwards from the end
+        char digits[24];
+        uint8_t at = sizeof(digits);
+
+        switch (spec.kind) {
+            case HEX_DIGITS:
+                do {
+                    digits[--at] = "0123456789abcdef"[magnitude & 0xF];
+                    magnitude >>= 4;
+                } while (magnitude);
+                break;
+            case FIXED_POINT:
+                for (uint8_t i = 0; i < spec.decimals; ++i) {
+                    digits[--at] = '0' + magnitude % 10;
+                    magnitude /= 10;
+                }
+                digits[--at] = '.';
+                at = decimal(digits, at, magnitude);
+                break;
+            case TIME_OF_DAY: {
+                const auto seconds = magnitude / 1000;
+                at = twoDigits(digits, at, seconds % 60);
+                digits[--at] = ':';
+                at = twoDigits(digits, at, seconds / 60 % 60);
+                digits[--at] = ':';
+                const auto hours = seconds / 3600;
+                at = hours < 10 ? twoDigits(digits, at, hours) : decimal(digits, at, hours);
+                break;
+            }
+            default:
+                at = decimal(digits, at, magnitude);
+        }
+
+        const uint8_t length = sizeof(digits) - at + isNegative;
+        const uint8_t padding = spec.width > length ? spec.width - length : 0;
+        if (!spec.isZeroPadded) writer.put(' ', padding);
+        if (isNegative) writer.put('-');
+        if (spec.isZeroPadded) writer.put('0', padding);
+        while (at < sizeof(digits)) writer.put(digits[at++]);
+    }
+
+private:
+    static void next(Writer& writer, const char* format) {
+        while (*format) writer.put(*format++);
+    }
+
+    template<typename T, typename... TRest>
+    static void next(Writer& writer, const char* format, const T& first, const TRest&... rest) {
+        while (*format && *format != '{') writer.put(*format++);
+        if (!*format) return;
+
+        Spec spec;
+        format = parseSpec(format + 1, spec);
+        if (!format) return;
+        argument(writer, spec, decayed(first));
+        next(writer, format, rest...);
+    }
+
+    template<typename T> static const T& decayed(const T& value) { return value; }
+    template<size_t N> static const char* decayed(const char (&value)[N]) { return value; }
+
+    // 16-bit divisions once the value fits them: on the AVR a 32-bit one costs several times more.
+    static uint8_t decimal(char* digits, uint8_t at, uint32_t value) {
+        while (value > 0xFFFF) {
+            digits[--at] = '0' + value % 10;
+            value /= 10;
+        }
+        uint16_t small = value;
+        do {
+            digits[--at] = '0' + small % 10;
+            small /= 10;
+        } while (small);
+        return at;
+    }
+
+    static uint8_t twoDigits(char* digits, uint8_t at, uint8_t value) {
+        digits[--at] = '0' + value % 10;
+        digits[--at] = '0' + value / 10;
+        return at;
+    }
+};
+
+// Number of arguments, for the compile-time checks of the macros.
+template<typename... TArgs> char (&formatArgumentCount(const TArgs&...))[sizeof...(TArgs) + 1];
+#define FORMAT_ARGUMENTS(...) (sizeof(formatArgumentCount(__VA_ARGS__)) - 1)
+
+// FORMAT(buffer, "{02}:{02}", hours, minutes) into a char array; the format must be a literal.
+#define FORMAT(buffer, format, ...) \
+    Format::into<Format::isValid(format, FORMAT_ARGUMENTS(__VA_ARGS__))>(buffer, sizeof(buffer), format, ##__VA_ARGS__)
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <Arduino.h>
+#include <BinaryProtocol.h>
+#include <EEPROM.h>
+#include <FixedContainers.h>
+
+/**
+ * Capture of the external inputs the firmware acts on, for replaying field problems on the host
+ * (sim/tools/Replay): the bytes StreamListener reads, the button levels Button takes from
+ * PinEdges, and what the firmware started from (EEPROM, pin levels at boot). Built in with
+ * `-D INPUT_TRACE=1`; otherwise every call is empty and the buffer a single byte.
+ *
+ * Records are a varint (LEB128) of `ms since the previous record << 2 | kind` and its payload:
+ *  - SERIAL_BYTE: the byte, stamped when it was read
+ *  - PIN_LEVEL: pin << 1 | level, stamped by the pin interrupt
+ *  - SNAPSHOT (always 0 ms): 0x80 | pin << 1 | level for a level at boot, or the index of a
+ *    SNAPSHOT_CHUNK of the EEPROM followed by its bytes
+ *  - GAP: u16 count of records lost to a full buffer before this one
+ * Time starts at boot. Records are buffered in RAM and sent by `drain`, whole, in
+ * BinaryProtocol::TRACE_RECORD frames (a frame sequence number, then the records) as far as the
+ * output can take them without blocking. `snapshot` sends the EEPROM before anything can write to
+ * it, blocking: a capture build boots about 1.5 s later at 9600 baud.
+ */
+
+#ifndef INPUT_TRACE
+#define INPUT_TRACE 0
+#endif
+
+template<uint8_t CAPACITY>
+struct InputTrace {
+    enum Kind: uint8_t { SERIAL_BYTE = 0, PIN_LEVEL = 1, SNAPSHOT = 2, GAP = 3 };
+
+    static const uint8_t SNAPSHOT_CHUNK = 16;
+    static const uint8_t SNAPSHOT_PIN = 0x80;
+    static const uint8_t MAX_FRAME_RECORDS_SIZE = 32;
+    // delimiters, COBS code byte, kind, sequence and CRC around the records
+    static const uint8_t FRAME_OVERHEAD = 2 + 1 + 2 + BinaryProtocol::CRC_SIZE;
+
+    uint16_t dropped = 0;
+    uint32_t droppedTotal = 0;
+
+    void serial(uint32_t atMs, uint8_t value) {
+        if (!INPUT_TRACE) return;
+        const uint8_t payload[] = {value};
+        record(atMs, SERIAL_BYTE, payload, sizeof(payload));
+    }
+
+    void pin(uint32_t atMs, uint8_t pin, bool isHigh) {
+        if (!INPUT_TRACE) return;
+        const uint8_t payload[] = {(uint8_t)(pin << 1 | isHigh)};
+        record(atMs, PIN_LEVEL, payload, sizeof(payload));
+    }
+
+    // A level the firmware found at boot rather than saw change.
+    void bootLevel(uint8_t pin, bool isHigh) {
+        if (!INPUT_TRACE) return;
+        const uint8_t payload[] = {(uint8_t)(SNAPSHOT_PIN | pin << 1 | isHigh)};
+        record(_lastMs, SNAPSHOT, payload, sizeof(payload));
+    }
+
+    // The EEPROM as the firmware is about to restore from it.
+    void snapshot(Print& output) {
+        if (!INPUT_TRACE) return;
+
+        for (uint8_t chunk = 0; chunk < SNAPSHOT_CHUNKS; ++chunk) {
+            uint8_t records[2 + SNAPSHOT_CHUNK] = {SNAPSHOT, chunk};
+            for (uint8_t i = 0; i < SNAPSHOT_CHUNK; ++i) records[2 + i] = EEPROM.read(chunk * SNAPSHOT_CHUNK + i);
+            send(output, records, sizeof(records));
+        }
+    }
+
+    bool isPending() const { return INPUT_TRACE && (!_records.isEmpty() || dropped); }
+
+    void drain(Print& output) {
+        if (!INPUT_TRACE) return;
+
+        while (!_records.isEmpty()) {
+            uint8_t records[MAX_FRAME_RECORDS_SIZE];
+            uint8_t size = 0;
+            uint8_t recordSize;
+            while (size < _records.size() && size + (recordSize = sizeAt(size)) <= sizeof(records)) {
+                for (uint8_t i = 0; i < recordSize; ++i) records[size + i] = _records[size + i];
+                size += recordSize;
+            }
+            if (output.availableForWrite() < size + FRAME_OVERHEAD) return;
+
+            send(output, records, size);
+            _records.pop(size);
+        }
+    }
+
+private:
+    // the ATmega32U4's EEPROM
+    static const uint16_t EEPROM_SIZE = 1024;
+    static const uint8_t SNAPSHOT_CHUNKS = EEPROM_SIZE / SNAPSHOT_CHUNK;
+
+    RingBuffer<uint8_t, CAPACITY> _records;
+    uint32_t _lastMs = 0;
+    uint8_t _sequence = 0;
+
+    void record(uint32_t atMs, Kind kind, const uint8_t* payload, uint8_t payloadSize) {
+        // records lost before this one are reported first, when there is room for both
+        const uint8_t gapSize = dropped ? 1 + 2 : 0;
+        if (_records.space() < gapSize + 5 + payloadSize) {
+            dropped++;
+            droppedTotal++;
+            return;
+        }
+        if (dropped) {
+            const uint8_t count[] = {(uint8_t)dropped, (uint8_t)(dropped >> 8)};
+            dropped = 0;
+            push(0, GAP, count, sizeof(count));
+        }
+
+        // stamps can trail the previous record a little (an edge taken after a byte was read)
+        const uint32_t deltaMs = (int32_t)(atMs - _lastMs) > 0 ? atMs - _lastMs : 0;
+        _lastMs += deltaMs;
+        push(deltaMs, kind, payload, payloadSize);
+    }
+
+    void push(uint32_t deltaMs, Kind kind, const uint8_t* payload, uint8_t payloadSize) {
+        // deltas of more than 2^30 ms (12 days) wrap
+        uint32_t header = deltaMs << 2 | kind;
+        do {
+            _records.push((header > 0x7F ? 0x80 : 0) | (header & 0x7F));
+            header >>= 7;
+        } while (header);
+        for (uint8_t i = 0; i < payloadSize; ++i) _records.push(payload[i]);
+    }
+
+    // Size of the record `offset` bytes past the head.
+    uint8_t sizeAt(uint8_t offset) const {
+        const auto kind = (Kind)(_records[offset] & 0b11);
+        uint8_t size = 0;
+        while (_records[offset + size++] & 0x80) {}
+        return size + (kind == GAP ? 2 : 1);
+    }
+
+    void send(Print& output, const uint8_t* records, uint8_t size) {
+        uint8_t frame[2 + MAX_FRAME_RECORDS_SIZE + BinaryProtocol::CRC_SIZE];
+        frame[0] = BinaryProtocol::TRACE_RECORD;
+        frame[1] = _sequence++;
+        memcpy(frame + 2, records, size);
+        const auto crc = BinaryProtocol::crc16(frame, 2 + size);
+        frame[2 + size] = crc;
+        frame[3 + size] = crc >> 8;
+        BinaryProtocol::send(output, frame, 2 + size + BinaryProtocol::CRC_SIZE);
+    }
+};
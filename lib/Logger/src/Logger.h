@@ -0,0 +1,224 @@
+#pragma once
+
+#include <Arduino.h>
+#include <BinaryProtocol.h>
+#include <FixedContainers.h>
+#include <Format.h>
+
+/**
+ * Tokenized, buffered logging.
+ *
+ * LOG_INFO("servo {}", angle) does not print: it appends a record (level, millis(), a 16 bit hash of
+ * the message literal, then the arguments as raw bytes) to a RAM ring, and `drain` later sends whole
+ * records as BinaryProtocol::LOG_RECORD frames, only as far as the output can take them without
+ * blocking. The literals themselves never reach the binary; sim/tools/LogDecode finds them in the
+ * sources by their hash and turns the records back into text.
+ *
+ * When the ring is full the record is dropped and counted; the count is reported as its own record
+ * once there is room again.
+ *
+ * Messages are Format strings, checked against their arguments at compile time; the specs
+ * (`{04x}`, `{.2}`, `{t}`...) cost nothing here and are applied by the decoder.
+ *
+ * Argument encoding: a tag byte (kind << 4 | size) followed by `size` bytes, little-endian for
+ * integers. Strings are cut at MAX_STRING_ARG bytes.
+ */
+
+#define LOG_ID(message) (LogId<logHash(message)>::value)
+
+#define LOG_AT(recordLevel, message, ...) do { \
+        static_assert(Format::isValid(message, FORMAT_ARGUMENTS(__VA_ARGS__)), "log message does not match its arguments"); \
+        if constexpr (recordLevel <= LOG_MODULE_LEVEL) logger.write(recordLevel, LOG_ID(message), ##__VA_ARGS__); \
+    } while (false)
+
+#define LOG_ERROR(message, ...) LOG_AT(LOG_LEVEL_ERROR, message, ##__VA_ARGS__)
+#define LOG_WARN(message, ...) LOG_AT(LOG_LEVEL_WARN, message, ##__VA_ARGS__)
+#define LOG_INFO(message, ...) LOG_AT(LOG_LEVEL_INFO, message, ##__VA_ARGS__)
+#define LOG_DEBUG(message, ...) LOG_AT(LOG_LEVEL_DEBUG, message, ##__VA_ARGS__)
+
+/**
+ * Levels:
+ *  - no logs 0
+ *  - error 1
+ *  - warn 2
+ *  - info 3
+ *  - debug 4
+ *
+ * The level is fixed at build time (`-D LOG_LEVEL=LOG_LEVEL_WARN`); calls above it are discarded by
+ * the compiler together with their arguments. Components that log a lot get their own level, which
+ * defaults to LOG_LEVEL: a struct declares
+ *
+ *     static constexpr LogLevel LOG_MODULE_LEVEL = LOG_LEVEL_BUTTON;
+ *
+ * and the LOG_* calls in its member functions pick it up by name; everything else uses the global one.
+ */
+enum LogLevel: uint8_t {
+    LOG_LEVEL_NONE = 0,
+    LOG_LEVEL_ERROR = 1,
+    LOG_LEVEL_WARN = 2,
+    LOG_LEVEL_INFO = 3,
+    LOG_LEVEL_DEBUG = 4,
+};
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+#endif
+#ifndef LOG_LEVEL_SCHEDULER
+#define LOG_LEVEL_SCHEDULER LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_BUTTON
+#define LOG_LEVEL_BUTTON LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_SERVO
+#define LOG_LEVEL_SERVO LOG_LEVEL
+#endif
+#ifndef LOG_LEVEL_STREAM
+#define LOG_LEVEL_STREAM LOG_LEVEL
+#endif
+
+static constexpr LogLevel LOG_MODULE_LEVEL = LOG_LEVEL;
+
+constexpr LogLevel logLevelMax(LogLevel first) { return first; }
+template<typename... TRest>
+constexpr LogLevel logLevelMax(LogLevel first, TRest... rest) {
+    return first > logLevelMax(rest...) ? first : logLevelMax(rest...);
+}
+
+// Highest level any module logs at; at LOG_LEVEL_NONE the logger has nothing to buffer or send.
+static constexpr LogLevel LOG_LEVEL_MAX = logLevelMax(LOG_LEVEL, LOG_LEVEL_SCHEDULER, LOG_LEVEL_BUTTON, LOG_LEVEL_SERVO, LOG_LEVEL_STREAM);
+
+// FNV-1a folded to 16 bits; the decoder uses the same function to index the message literals.
+constexpr uint16_t logHash(const char* message) {
+    uint32_t hash = 2166136261UL;
+    while (*message) {
+        hash ^= (uint8_t)*message++;
+        hash *= 16777619UL;
+    }
+    return (uint16_t)(hash ^ (hash >> 16));
+}
+
+template<uint16_t ID> struct LogId { static constexpr uint16_t value = ID; };
+
+template<uint8_t CAPACITY>
+struct Logger {
+    static const uint8_t HEADER_SIZE = 1 + 1 + 4 + 2;
+    static const uint8_t MAX_RECORD_SIZE = 40;
+    static const uint8_t MAX_STRING_ARG = 15;
+    // delimiters, COBS code byte and CRC around a record on the wire
+    static const uint8_t FRAME_OVERHEAD = 2 + 1 + BinaryProtocol::CRC_SIZE;
+
+    enum ArgKind: uint8_t { UNSIGNED = 0, SIGNED = 1, STRING = 2 };
+
+    uint16_t dropped = 0;
+    uint32_t droppedTotal = 0;
+
+    template<typename... TArgs>
+    void write(LogLevel recordLevel, uint16_t id, const TArgs&... args) {
+        const uint8_t size = HEADER_SIZE + argsSize(args...);
+        if (size > MAX_RECORD_SIZE || _records.space() < size) {
+            dropped++;
+            droppedTotal++;
+            return;
+        }
+
+        push(size);
+        push(recordLevel);
+        push32(millis());
+        push(id);
+        push(id >> 8);
+        pushArgs(args...);
+    }
+
+    // Sends complete records while `output` can take them without blocking.
+    void drain(Print& output) {
+        if (LOG_LEVEL_MAX == LOG_LEVEL_NONE) return;
+
+        if (dropped && output.availableForWrite() >= HEADER_SIZE + 3 + FRAME_OVERHEAD) {
+            const auto timestamp = millis();
+            const uint8_t record[] = {
+                    (uint8_t)(BinaryProtocol::LOG_RECORD | LOG_LEVEL_WARN),
+                    (uint8_t)timestamp, (uint8_t)(timestamp >> 8), (uint8_t)(timestamp >> 16), (uint8_t)(timestamp >> 24),
+                    (uint8_t)DROPPED_ID, (uint8_t)(DROPPED_ID >> 8),
+                    UNSIGNED << 4 | 2, (uint8_t)dropped, (uint8_t)(dropped >> 8),
+            };
+            sendRecord(output, record, sizeof(record));
+            dropped = 0;
+        }
+
+        while (!_records.isEmpty()) {
+            const uint8_t size = _records.front();
+            if (output.availableForWrite() < size - 1 + FRAME_OVERHEAD) return;
+
+            uint8_t record[MAX_RECORD_SIZE];
+            for (uint8_t i = 0; i < size; ++i) record[i] = _records[i];
+            _records.pop(size);
+
+            // on the wire the size byte gives way to the frame kind
+            record[1] |= BinaryProtocol::LOG_RECORD;
+            sendRecord(output, record + 1, size - 1);
+        }
+    }
+
+    uint8_t used() const { return _records.size(); }
+
+private:
+    static constexpr uint16_t DROPPED_ID = logHash("dropped {} records");
+
+    RingBuffer<uint8_t, CAPACITY> _records;
+
+    static void sendRecord(Print& output, const uint8_t* record, uint8_t size) {
+        uint8_t frame[MAX_RECORD_SIZE + BinaryProtocol::CRC_SIZE];
+        if (size > MAX_RECORD_SIZE) return;
+        memcpy(frame, record, size);
+        const auto crc = BinaryProtocol::crc16(frame, size);
+        frame[size] = crc;
+        frame[size + 1] = crc >> 8;
+        BinaryProtocol::send(output, frame, size + BinaryProtocol::CRC_SIZE);
+    }
+
+    void push(uint8_t value) { _records.push(value); }
+
+    void push32(uint32_t value) {
+        for (uint8_t i = 0; i < 4; ++i) push(value >> (8 * i));
+    }
+
+    static uint8_t argsSize() { return 0; }
+    template<typename T, typename... TRest>
+    static uint8_t argsSize(const T& first, const TRest&... rest) { return 1 + argSize(first) + argsSize(rest...); }
+
+    void pushArgs() {}
+    template<typename T, typename... TRest>
+    void pushArgs(const T& first, const TRest&... rest) {
+        pushArg(first);
+        pushArgs(rest...);
+    }
+
+    // integers wider than 32 bits (long on the host) are sent as their low 32 bits
+    template<typename T> static uint8_t argSize(const T&) { return sizeof(T) > 4 ? 4 : sizeof(T); }
+    static uint8_t argSize(const char* value) {
+        const auto length = strlen(value);
+        return length > MAX_STRING_ARG ? MAX_STRING_ARG : length;
+    }
+    template<size_t N> static uint8_t argSize(const char (&value)[N]) { return argSize((const char*)value); }
+
+    void pushInteger(uint32_t value, uint8_t size, ArgKind kind) {
+        push(kind << 4 | size);
+        for (uint8_t i = 0; i < size; ++i) push(value >> (8 * i));
+    }
+
+    void pushArg(bool value) { pushInteger(value, 1, UNSIGNED); }
+    void pushArg(unsigned char value) { pushInteger(value, sizeof(value), UNSIGNED); }
+    void pushArg(unsigned short value) { pushInteger(value, sizeof(value), UNSIGNED); }
+    void pushArg(unsigned int value) { pushInteger(value, sizeof(value), UNSIGNED); }
+    void pushArg(unsigned long value) { pushInteger(value, argSize(value), UNSIGNED); }
+    void pushArg(signed char value) { pushInteger(value, sizeof(value), SIGNED); }
+    void pushArg(short value) { pushInteger(value, sizeof(value), SIGNED); }
+    void pushArg(int value) { pushInteger(value, sizeof(value), SIGNED); }
+    void pushArg(long value) { pushInteger(value, argSize(value), SIGNED); }
+    void pushArg(const char* value) {
+        const auto length = argSize(value);
+        push(STRING << 4 | length);
+        for (uint8_t i = 0; i < length; ++i) push(value[i]);
+    }
+    template<size_t N> void pushArg(const char (&value)[N]) { pushArg((const char*)value); }
+};
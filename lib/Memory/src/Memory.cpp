@@ -0,0 +1,74 @@
+#ifdef __AVR__
+
+#include "Memory.h"
+
+#include <stdlib.h>
+
+// avr-libc's malloc state (malloc.c, stdlib_private.h)
+struct __freelist {
+    size_t sz;
+    struct __freelist* nx;
+};
+
+extern char __heap_start;
+extern char* __brkval;
+extern struct __freelist* __flp;
+
+namespace {
+
+// Paints from the end of .bss up to the top of the SRAM. Runs from .init1, before the stack is
+// set up and anything is zeroed, so it must not touch the stack or r1.
+__attribute__((naked, used, section(".init1"))) void paintStack() {
+    __asm__ __volatile__(
+            "    ldi r30, lo8(_end)\n"
+            "    ldi r31, hi8(_end)\n"
+            "    ldi r24, %0\n"
+            "    ldi r25, hi8(__stack)\n"
+            "    rjmp 2f\n"
+            "1:  st Z+, r24\n"
+            "2:  cpi r30, lo8(__stack)\n"
+            "    cpc r31, r25\n"
+            "    brlo 1b\n"
+            "    breq 1b\n"
+            :: "M"(Memory::CANARY));
+}
+
+char* heapTop() { return __brkval ? __brkval : &__heap_start; }
+
+uint16_t gapToStack() {
+    char top;
+    const auto gap = &top - heapTop();
+    // malloc keeps __malloc_margin bytes clear of the stack
+    return gap > (int16_t)__malloc_margin ? gap - __malloc_margin : 0;
+}
+
+}
+
+uint16_t Memory::unusedStack() {
+    const auto* cell = (const uint8_t*)heapTop();
+    const auto* const stackPointer = (const uint8_t*)SP;
+    uint16_t unused = 0;
+    while (cell < stackPointer && *cell++ == CANARY) unused++;
+    return unused;
+}
+
+uint16_t Memory::freeNow() {
+    char top;
+    return &top - heapTop();
+}
+
+uint16_t Memory::freeHeap() {
+    uint16_t free = gapToStack();
+    for (auto chunk = __flp; chunk; chunk = chunk->nx) free += chunk->sz;
+    return free;
+}
+
+uint16_t Memory::largestFreeBlock() {
+    uint16_t largest = gapToStack();
+    for (auto chunk = __flp; chunk; chunk = chunk->nx) {
+        if (chunk->sz > largest) largest = chunk->sz;
+    }
+    return largest;
+}
+
+#endif
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * How much of the SRAM is left between the heap and the stack, which grow towards each other.
+ *
+ * At reset, before anything runs, the whole space above .bss is painted with a canary byte.
+ * Whatever the stack ever reached it has overwritten, so counting the canaries left above the
+ * top of the heap gives the least free space there has been since boot, without any cost on the
+ * way. Memory freed at the top of the heap is not painted again, and is not counted either.
+ *
+ * The heap figures walk avr-libc's free list: `freeHeap` is what malloc could still hand out in
+ * all, `largestFreeBlock` the biggest single allocation that would succeed now.
+ */
+struct Memory {
+    static const uint8_t CANARY = 0xC5;
+
+    // Bytes never reached by the stack, above the current top of the heap.
+    static uint16_t unusedStack();
+    // Bytes between the top of the heap and the stack pointer now.
+    static uint16_t freeNow();
+    static uint16_t freeHeap();
+    static uint16_t largestFreeBlock();
+};
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Sleep.h>
+
+/**
+ * Single-producer/single-consumer ring without locks: an ISR pushes, the main loop peeks and pops.
+ *
+ * Each side owns one index (one byte, so reads and writes are atomic on AVR) and the item is
+ * written before the producer publishes its new tail. When the ring is full the new item is
+ * dropped and counted.
+ */
+template<typename TItem, uint8_t CAPACITY>
+struct SpscQueue {
+    static_assert(CAPACITY && !(CAPACITY & (CAPACITY - 1)) && CAPACITY <= 128, "capacity must be a power of two up to 128");
+
+    // producer
+    bool push(const TItem& item) {
+        const uint8_t tail = _tail;
+        if ((uint8_t)(tail - _head) == CAPACITY) {
+            _overflows++;
+            return false;
+        }
+
+        _items[tail & MASK] = item;
+        barrier();
+        _tail = tail + 1;
+        return true;
+    }
+
+    // consumer
+    bool peek(TItem& item) const {
+        const uint8_t head = _head;
+        if (head == _tail) return false;
+
+        barrier();
+        item = _items[head & MASK];
+        return true;
+    }
+    void pop() {
+        barrier();
+        if (_head != _tail) _head = _head + 1;
+    }
+    bool isEmpty() const { return _head == _tail; }
+
+    uint16_t overflows() const {
+        noInterrupts();
+        const uint16_t overflows = _overflows;
+        interrupts();
+        return overflows;
+    }
+
+private:
+    static const uint8_t MASK = CAPACITY - 1;
+
+    TItem _items[CAPACITY]{};
+    volatile uint8_t _head = 0;
+    volatile uint8_t _tail = 0;
+    volatile uint16_t _overflows = 0;
+
+    static void barrier() { __asm__ __volatile__("" ::: "memory"); }
+};
+
+struct PinEdge {
+    uint32_t atMs;
+    uint8_t pin;
+    bool isHigh;
+};
+
+/**
+ * Level changes of the watched pins, stamped with millis() in one shared interrupt handler and
+ * queued in order for the main loop. Readers take only the edges of their own pin from the front,
+ * so several buttons can share the queue as long as all of them are reacted to every pass.
+ *
+ * An edge that wakes the MCU from power-down is stamped after Sleep::settle() has caught millis()
+ * up, so durations between edges stay exact even when the time of day is not.
+ */
+struct PinEdges {
+    static const uint8_t MAX_PINS = 4;
+    static const uint8_t CAPACITY = 16;
+
+    // Attaches the shared handler; returns false when the pin has no interrupt or no slot is left.
+    static bool watch(uint8_t pin) {
+        const auto interrupt = digitalPinToInterrupt(pin);
+        if (interrupt == NOT_AN_INTERRUPT || _count == MAX_PINS) return false;
+
+        noInterrupts();
+        _pins[_count] = pin;
+        _levels[_count] = digitalRead(pin);
+        _count++;
+        interrupts();
+        attachInterrupt(interrupt, onChange, CHANGE);
+        return true;
+    }
+
+    static bool peek(PinEdge& edge) { return _queue.peek(edge); }
+    static void pop() { _queue.pop(); }
+    static bool isPending() { return !_queue.isEmpty(); }
+    static uint16_t overflows() { return _queue.overflows(); }
+
+private:
+    static inline SpscQueue<PinEdge, CAPACITY> _queue;
+    static inline uint8_t _pins[MAX_PINS]{};
+    static inline bool _levels[MAX_PINS]{};
+    static inline uint8_t _count = 0;
+
+    static void onChange() {
+        Sleep::settle();
+        Sleep::noteInput();
+        const uint32_t now = millis();
+        for (uint8_t i = 0; i < _count; ++i) {
+            const bool level = digitalRead(_pins[i]);
+            if (level == _levels[i]) continue;
+
+            // a dropped edge leaves the level as last queued, so the next change is still seen
+            if (_queue.push(PinEdge{now, _pins[i], level})) _levels[i] = level;
+        }
+    }
+};
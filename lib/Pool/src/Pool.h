@@ -0,0 +1,125 @@
+#pragma once
+
+#include <Arduino.h>
+
+#ifdef __AVR__
+#include <new.h>
+#else
+#include <new>
+#endif
+
+/**
+ * Fixed-capacity object pool: storage for CAPACITY objects reserved at compile time, allocation and
+ * release in O(1) through a free list of slot indices, no heap.
+ *
+ * Objects are referred to from outside (serial commands) by handles, `generation << 8 | slot`.
+ * A slot's generation moves on every time its object is destroyed, so a handle kept after that
+ * no longer resolves, even once the slot holds a new object. Generations skip 0, which makes
+ * NONE (0) an invalid handle for every slot.
+ */
+template<typename T, uint8_t CAPACITY>
+struct Pool {
+    typedef uint16_t Handle;
+    static const Handle NONE = 0;
+
+    static_assert(CAPACITY && CAPACITY < 0xFF, "pool capacity must fit a slot index");
+
+    Pool() {
+        for (uint8_t i = 0; i < CAPACITY; ++i) {
+            _next[i] = i + 1;
+            _generations[i] = 1;
+        }
+    }
+
+    ~Pool() {
+        for (uint8_t i = 0; i < CAPACITY; ++i) {
+            if (_isUsed[i]) at(i)->~T();
+        }
+    }
+
+    Pool(const Pool&) = delete;
+    Pool& operator=(const Pool&) = delete;
+
+    // Constructs a T in a free slot; NONE when the pool is full.
+    template<typename... TArgs>
+    Handle create(const TArgs&... args) {
+        if (_free == END) return NONE;
+
+        const uint8_t slot = _free;
+        _free = _next[slot];
+        new (_storage[slot]) T(args...);
+        _isUsed[slot] = true;
+        _used++;
+        return (Handle)_generations[slot] << 8 | slot;
+    }
+
+    // Re-creates an object under a handle given out before a reset; NONE if its slot is taken.
+    template<typename... TArgs>
+    Handle createAt(Handle handle, const TArgs&... args) {
+        const uint8_t slot = handle & 0xFF;
+        if (slot >= CAPACITY || _isUsed[slot] || !(handle >> 8)) return NONE;
+
+        auto link = &_free;
+        while (*link != slot) link = &_next[*link];
+        *link = _next[slot];
+        _generations[slot] = handle >> 8;
+        new (_storage[slot]) T(args...);
+        _isUsed[slot] = true;
+        _used++;
+        return handle;
+    }
+
+    // Moves a free slot on to the generation of `handle`, so that handles given out before it
+    // stay stale after a reset.
+    void skipTo(Handle handle) {
+        const uint8_t slot = handle & 0xFF;
+        if (slot < CAPACITY && !_isUsed[slot] && handle >> 8) _generations[slot] = handle >> 8;
+    }
+
+    // The object behind `handle`, or nullptr if it has been destroyed since.
+    T* get(Handle handle) const {
+        const uint8_t slot = handle & 0xFF;
+        if (slot >= CAPACITY || !_isUsed[slot] || _generations[slot] != handle >> 8) return nullptr;
+        return at(slot);
+    }
+
+    // The handle of an object living in this pool, NONE for anything else.
+    Handle handleOf(const T* item) const {
+        for (uint8_t slot = 0; slot < CAPACITY; ++slot) {
+            if (_isUsed[slot] && at(slot) == item) return (Handle)_generations[slot] << 8 | slot;
+        }
+        return NONE;
+    }
+
+    // The handle of the object in `slot`, or the one the next object created there will get.
+    Handle handleAt(uint8_t slot) const { return (Handle)_generations[slot] << 8 | slot; }
+
+    bool destroy(Handle handle) {
+        const auto item = get(handle);
+        if (!item) return false;
+
+        const uint8_t slot = handle & 0xFF;
+        item->~T();
+        _isUsed[slot] = false;
+        if (!++_generations[slot]) _generations[slot] = 1;
+        _next[slot] = _free;
+        _free = slot;
+        _used--;
+        return true;
+    }
+
+    uint8_t used() const { return _used; }
+    static constexpr uint8_t capacity() { return CAPACITY; }
+
+private:
+    static const uint8_t END = CAPACITY;
+
+    alignas(T) uint8_t _storage[CAPACITY][sizeof(T)];
+    uint8_t _next[CAPACITY];
+    uint8_t _generations[CAPACITY];
+    bool _isUsed[CAPACITY]{};
+    uint8_t _free = 0;
+    uint8_t _used = 0;
+
+    T* at(uint8_t slot) const { return (T*)_storage[slot]; }
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * Time spent in the sections of the main loop, for finding what makes a pass slow.
+ *
+ * Per section it keeps the number of calls, their total and longest duration, and a histogram of
+ * durations in powers of two: bucket 0 counts calls under 2 us, bucket k those from 2^k us up to
+ * 2^(k+1) us, and the last bucket everything longer. Durations come from micros(), which on a
+ * 16 MHz AVR moves in steps of 4 us: bucket 0 holds the calls shorter than a step and bucket 1
+ * stays empty. Sums wrap after about 71 minutes of time inside a section, and the histogram
+ * counts stop at 65535; read and reset the sections more often than that.
+ *
+ * Built in with `-D PROFILER=1`. Otherwise nothing is timed, every call compiles to the code it
+ * wraps, and the profiler, referenced by nothing, is left out by the linker.
+ */
+
+#ifndef PROFILER
+#define PROFILER 0
+#endif
+
+template<uint8_t SECTIONS>
+struct Profiler {
+    static const uint8_t BUCKETS = 12;
+
+    struct Stats {
+        uint32_t count;
+        uint32_t totalUs;
+        uint16_t maxUs;
+        uint16_t histogram[BUCKETS];
+    };
+
+    uint32_t start() const { return PROFILER ? micros() : 0; }
+
+    void stop(uint8_t section, uint32_t startUs) {
+        if (!PROFILER || section >= SECTIONS) return;
+
+        const uint32_t us = micros() - startUs;
+        auto& stats = _stats[section];
+        stats.count++;
+        stats.totalUs += us;
+        if (us > stats.maxUs) stats.maxUs = us > 0xFFFF ? 0xFFFF : us;
+        auto& bucket = stats.histogram[bucketOf(us)];
+        if (bucket != 0xFFFF) bucket++;
+    }
+
+    // Runs `body` as one call of `section`.
+    template<typename TBody>
+    void measure(uint8_t section, TBody body) {
+        const auto startUs = start();
+        body();
+        stop(section, startUs);
+    }
+
+    const Stats& stats(uint8_t section) const { return _stats[PROFILER && section < SECTIONS ? section : 0]; }
+
+    void reset(uint8_t section) {
+        if (PROFILER && section < SECTIONS) _stats[section] = Stats{};
+    }
+
+    static uint8_t bucketOf(uint32_t us) {
+        uint8_t bucket = 0;
+        while (us > 1 && bucket < BUCKETS - 1) {
+            us >>= 1;
+            bucket++;
+        }
+        return bucket;
+    }
+
+    // Shortest duration counted in `bucket`.
+    static uint16_t bucketStartUs(uint8_t bucket) { return bucket ? 1 << bucket : 0; }
+
+private:
+    Stats _stats[PROFILER ? SECTIONS : 1]{};
+};
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <Arduino.h>
+#include <EEPROM.h>
+
+/**
+ * Log-structured key/value store in EEPROM, for a handful of small values that have to survive a
+ * reset.
+ *
+ * The SIZE bytes from BASE are a ring of fixed-size records: a sequence number, the key, an 8-bit
+ * tag and a 32-bit value, protected by a CRC-8. A write appends a record at the head and never
+ * touches anything else, so the cells wear evenly around the ring, and a value that did not change
+ * is not written at all. The newest valid record of a key is its value; older ones are garbage.
+ *
+ * Compaction is done a record at a time, ahead of the head: whenever the slot after it still
+ * holds another key's newest record, that record is copied to the head first. The slot written
+ * next is thus always garbage. Its key is cleared first and written last, so a write cut short by
+ * a reset leaves a slot that reads as erased and the previous state intact; the CRC catches
+ * anything else.
+ *
+ * `restore` reads every slot once, so boot takes the same time however the ring was used.
+ *
+ * Built with RECORD_LOG_DRY_RUN (the cycle benchmarks, src/Benchmarks.h), records are laid out and
+ * accounted for as usual but never reach EEPROM, so every write takes the writing path.
+ */
+
+#ifndef RECORD_LOG_DRY_RUN
+#define RECORD_LOG_DRY_RUN 0
+#endif
+
+template<uint16_t BASE, uint16_t SIZE, uint8_t KEYS>
+struct RecordLog {
+    struct Record {
+        uint8_t key;
+        uint16_t sequence;
+        uint8_t tag;
+        uint32_t value;
+        uint8_t crc;
+    } __attribute__((packed));
+
+    static const uint8_t SLOTS = SIZE / sizeof(Record);
+
+    static_assert(SLOTS > KEYS + 1, "the ring must hold every key and a free slot");
+    static_assert(SIZE / sizeof(Record) < 0xFF, "slots must fit a byte");
+
+    RecordLog() { for (uint8_t key = 0; key < KEYS; ++key) _latest[key] = NONE; }
+
+    void restore() {
+        uint16_t sequences[KEYS];
+        for (uint8_t key = 0; key < KEYS; ++key) _latest[key] = NONE;
+        _head = 0;
+        _sequence = 0;
+        auto isEmpty = true;
+
+        Record record;
+        for (uint8_t slot = 0; slot < SLOTS; ++slot) {
+            if (!load(slot, record)) continue;
+
+            if (isEmpty || isNewer(record.sequence, _sequence - 1)) {
+                _sequence = record.sequence + 1;
+                _head = next(slot);
+                isEmpty = false;
+            }
+            if (_latest[record.key] == NONE || isNewer(record.sequence, sequences[record.key])) {
+                _latest[record.key] = slot;
+                sequences[record.key] = record.sequence;
+            }
+        }
+    }
+
+    bool read(uint8_t key, uint8_t& tag, uint32_t& value) const {
+        Record record;
+        if (key >= KEYS || _latest[key] == NONE || !load(_latest[key], record)) return false;
+        tag = record.tag;
+        value = record.value;
+        return true;
+    }
+
+    // Appends the value unless it is the stored one already; true if anything was written.
+    bool write(uint8_t key, uint8_t tag, uint32_t value) {
+        if (key >= KEYS) return false;
+
+        uint8_t storedTag;
+        uint32_t storedValue;
+        if (read(key, storedTag, storedValue) && storedTag == tag && storedValue == value) return false;
+
+        // the key's own record in the way is superseded by this one, it need not move
+        Record record;
+        uint8_t owner;
+        while ((owner = keyAt(next(_head))) != NONE && owner != key && load(next(_head), record)) {
+            append(record);
+            moved++;
+        }
+
+        record.key = key;
+        record.tag = tag;
+        record.value = value;
+        append(record);
+        return true;
+    }
+
+    // Records written since boot, and how many of them were copies made by compaction.
+    uint32_t written = 0;
+    uint32_t moved = 0;
+
+private:
+    static const uint8_t NONE = 0xFF;
+    static const uint8_t ERASED = 0xFF;
+
+    uint8_t _latest[KEYS];
+    uint8_t _head = 0;
+    uint16_t _sequence = 0;
+
+    static uint8_t next(uint8_t slot) { return slot + 1 == SLOTS ? 0 : slot + 1; }
+
+    // Sequence numbers wrap; every valid record is within one lap of the ring of the newest.
+    static bool isNewer(uint16_t sequence, uint16_t than) { return (int16_t)(sequence - than) > 0; }
+
+    // The key whose newest record is in `slot`, NONE for garbage.
+    uint8_t keyAt(uint8_t slot) const {
+        for (uint8_t key = 0; key < KEYS; ++key) {
+            if (_latest[key] == slot) return key;
+        }
+        return NONE;
+    }
+
+    void append(Record& record) {
+        record.sequence = _sequence++;
+        record.crc = crc8((const uint8_t*)&record, sizeof(Record) - 1);
+
+        if (!RECORD_LOG_DRY_RUN) {
+            const auto address = BASE + _head * sizeof(Record);
+            const auto bytes = (const uint8_t*)&record;
+            EEPROM.update(address, ERASED);
+            for (uint8_t i = 1; i < sizeof(Record); ++i) EEPROM.update(address + i, bytes[i]);
+            EEPROM.update(address, record.key);
+        }
+
+        _latest[record.key] = _head;
+        _head = next(_head);
+        written++;
+    }
+
+    static bool load(uint8_t slot, Record& record) {
+        const auto address = BASE + slot * sizeof(Record);
+        const auto bytes = (uint8_t*)&record;
+        for (uint8_t i = 0; i < sizeof(Record); ++i) bytes[i] = EEPROM.read(address + i);
+
+        return record.key < KEYS && record.crc == crc8(bytes, sizeof(Record) - 1);
+    }
+
+    // CRC-8/MAXIM with a non-zero start, so a zeroed record does not pass either.
+    static uint8_t crc8(const uint8_t* data, uint8_t length) {
+        uint8_t crc = 0xFF;
+        while (length--) {
+            crc ^= *data++;
+            for (uint8_t bit = 0; bit < 8; ++bit) crc = crc & 1 ? (crc >> 1) ^ 0x8C : crc >> 1;
+        }
+        return crc;
+    }
+};
@@ -0,0 +1,114 @@
+#ifdef __AVR__
+
+#include "Sleep.h"
+
+#include <avr/sleep.h>
+#include <avr/wdt.h>
+
+// Arduino's millis() counter (wiring.c); Timer0 is stopped in power-down.
+extern volatile unsigned long timer0_millis;
+
+namespace {
+
+const uint8_t NOT_SLEEPING = 0xFF;
+
+int8_t pinInterrupt = NOT_AN_INTERRUPT;
+int8_t serialInterrupt = NOT_AN_INTERRUPT;
+volatile bool hasWatchdogFired = false;
+volatile bool hasInput = false;
+volatile uint8_t sleepingPeriod = NOT_SLEEPING;
+
+void onSerialInput() {
+    Sleep::settle();
+    Sleep::noteInput();
+}
+
+bool canPowerDown(uint8_t sources) {
+    if ((sources & WAKE_PIN_CHANGE) && pinInterrupt == NOT_AN_INTERRUPT) return false;
+#ifdef USBCON
+    if ((sources & WAKE_SERIAL) && serialInterrupt == NOT_AN_INTERRUPT && USBDevice.configured()) return false;
+#else
+    if ((sources & WAKE_SERIAL) && serialInterrupt == NOT_AN_INTERRUPT) return false;
+#endif
+    return true;
+}
+
+void startWatchdog(uint8_t period) {
+    const uint8_t prescaler = (period & 0b0111) | (period & 0b1000 ? _BV(WDP3) : 0);
+    noInterrupts();
+    wdt_reset();
+    MCUSR &= ~_BV(WDRF);
+    WDTCSR = _BV(WDCE) | _BV(WDE);
+    WDTCSR = _BV(WDIE) | prescaler;
+    interrupts();
+}
+
+}
+
+ISR(WDT_vect) {
+    hasWatchdogFired = true;
+    Sleep::settle();
+}
+
+void Sleep::watchPin(uint8_t pin) { pinInterrupt = digitalPinToInterrupt(pin); }
+
+void Sleep::watchSerial(uint8_t rxPin) { serialInterrupt = digitalPinToInterrupt(rxPin); }
+
+void Sleep::until(const Wake& wake) {
+    if (!wake.inMs) return;
+
+    if (modeFor(wake) == IDLE || !canPowerDown(wake.sources)) {
+        set_sleep_mode(SLEEP_MODE_IDLE);
+        noInterrupts();
+        if (hasInput) {
+            interrupts();
+            return;
+        }
+        sleep_enable();
+        // sei lets the next instruction run before any interrupt: an input now ends the sleep
+        interrupts();
+        sleep_cpu();
+        sleep_disable();
+        return;
+    }
+
+    const auto period = watchdogPeriodFor(wake.inMs);
+    // only attached for the sleep: an RX pin interrupt would otherwise fire on every bit
+    const auto isSerialWatched = (wake.sources & WAKE_SERIAL) && serialInterrupt != NOT_AN_INTERRUPT;
+    if (isSerialWatched) attachInterrupt(serialInterrupt, onSerialInput, FALLING);
+
+    hasWatchdogFired = false;
+    startWatchdog(period);
+
+    set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+    noInterrupts();
+    if (!hasInput) {
+        sleepingPeriod = period;
+        sleep_enable();
+        interrupts();
+        sleep_cpu();
+        sleep_disable();
+    }
+    interrupts();
+
+    wdt_disable();
+    if (isSerialWatched) detachInterrupt(serialInterrupt);
+
+    noInterrupts();
+    settle();
+    interrupts();
+}
+
+void Sleep::noteInput() { hasInput = true; }
+
+void Sleep::clearInput() { hasInput = false; }
+
+void Sleep::settle() {
+    const auto period = sleepingPeriod;
+    if (period == NOT_SLEEPING) return;
+
+    sleepingPeriod = NOT_SLEEPING;
+    timer0_millis += hasWatchdogFired ? watchdogPeriodMs(period) : watchdogPeriodMs(period) / 2;
+}
+
+#endif
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * Sleeping between loop passes.
+ *
+ * Every component reports a Wake: how long it can go without being reacted to, and which inputs
+ * must still be able to wake it earlier. The main loop merges them and hands the earliest to
+ * `Sleep::until`, which picks the deepest mode that keeps those inputs alive:
+ *
+ *  - idle: every clock keeps running and any interrupt wakes the CPU, the Timer0 tick (about every
+ *    ms) at the latest. Needed while the servo is driven, for short waits and while USB is up.
+ *  - power-down: only the watchdog, the watched pin and the serial RX pin can wake it. The wait is
+ *    cut into watchdog periods (16 ms << k, up to 8 s) and millis() is advanced by `settle`, from
+ *    the first interrupt handler that runs on waking; an input that cuts a period short is
+ *    credited half of it, since the watchdog cannot be read.
+ *    The oscillator takes about a ms to restart, so the byte that wakes a sleeping USART is lost:
+ *    hosts send a terminator first, which the stream listener ignores.
+ */
+
+enum WakeSource: uint8_t {
+    WAKE_PIN_CHANGE = 0b00000001,
+    WAKE_SERIAL = 0b00000010,
+    // not an input: timers must keep running (servo pulses), which rules out power-down
+    WAKE_KEEP_CLOCKS = 0b00000100,
+};
+
+struct Wake {
+    static const uint32_t NEVER = 0xFFFFFFFF;
+
+    uint32_t inMs = 0;
+    uint8_t sources = 0;
+
+    constexpr Wake earliest(const Wake& other) const {
+        return Wake{inMs < other.inMs ? inMs : other.inMs, (uint8_t)(sources | other.sources)};
+    }
+};
+
+struct Sleep {
+    enum Mode: uint8_t { IDLE, POWER_DOWN };
+
+    static const uint8_t WATCHDOG_PERIOD_MS = 16;
+    static const uint8_t MAX_WATCHDOG_PERIOD = 9;
+    // oscillator start-up after power-down, 16K clocks at 16 MHz
+    static const uint16_t POWER_DOWN_WAKE_UP_US = 1024;
+
+    static constexpr Mode modeFor(const Wake& wake) {
+        return (wake.sources & WAKE_KEEP_CLOCKS) || wake.inMs < WATCHDOG_PERIOD_MS ? IDLE : POWER_DOWN;
+    }
+
+    // Longest watchdog period (as the k in 16 ms << k) that does not overshoot `ms`.
+    static constexpr uint8_t watchdogPeriodFor(uint32_t ms) {
+        uint8_t period = 0;
+        while (period < MAX_WATCHDOG_PERIOD && (uint32_t)WATCHDOG_PERIOD_MS << (period + 1) <= ms) ++period;
+        return period;
+    }
+
+    static constexpr uint32_t watchdogPeriodMs(uint8_t period) { return (uint32_t)WATCHDOG_PERIOD_MS << period; }
+
+    // The pin behind WAKE_PIN_CHANGE. Its owner keeps a CHANGE interrupt attached (see PinEdges.h)
+    // that calls `settle` and `noteInput` first; without an external interrupt on the pin power-down is not used.
+    static void watchPin(uint8_t pin);
+    // RX pin of a USART behind WAKE_SERIAL. Without one the serial port is taken to be USB, which
+    // keeps the CPU in idle while the host is connected and cannot receive anything otherwise.
+    static void watchSerial(uint8_t rxPin);
+
+    // Returns at once, without sleeping, if an input was noted since `clearInput`: the wake was
+    // worked out before it came in. The check is made with interrupts off, right up to the sleep.
+    static void until(const Wake& wake);
+    // Credits the time spent powered down to millis(), once; for interrupt handlers that read it.
+    static void settle();
+    // For the interrupt handlers of watched inputs. The main loop clears the note before it asks the
+    // components for their wake, so an input from then on cannot be slept through.
+    static void noteInput();
+    static void clearInput();
+};
@@ -0,0 +1,111 @@
+#!/usr/bin/env sh
+# Cycle counts of the firmware's hot paths on the ATmega32U4 (src/Benchmarks.h, run under simavr)
+# and its flash and SRAM from avr-size, written to a results file; the results already there, from
+# the run before, are compared against and what changed is listed. Builds the avr_bench and default
+# environments from platformio.ini and needs simavr on the PATH; run from anywhere inside the project.
+#
+#   scripts/avr_bench.sh [RESULTS]    (default .pio/avr_bench.json)
+#
+# RESULTS is JSON, one entry per line: "firmware" and "bench_build" with their flash and sram, and
+# under "cycles" the least, mean and most of each case over its runs (65535: one run overflowed
+# the 16-bit count).
+
+set -e
+cd "$(dirname "$0")/.."
+
+results=${1:-.pio/avr_bench.json}
+MCU=atmega32u4
+F_CPU=16000000
+
+platformio run -s -e avr_bench >/dev/null
+platformio run -s -e sparkfun_promicro16 >/dev/null
+tool() { platformio pkg exec -s -p toolchain-atmelavr -- "$@"; }
+
+# avr-size -A: .text + .data live in flash, .data + .bss in SRAM
+sizes() {
+    tool avr-size -A "$1" | awk '
+        $1 == ".text" { text = $2 } $1 == ".data" { data = $2 } $1 == ".bss" { bss = $2 }
+        END { print text + data, data + bss }'
+}
+set -- $(sizes .pio/build/sparkfun_promicro16/firmware.elf) $(sizes .pio/build/avr_bench/firmware.elf)
+flash=$1 sram=$2 benchFlash=$3 benchSram=$4
+
+output=$(mktemp)
+current=$(mktemp)
+trap 'rm -f "$output" "$current"' EXIT
+
+# the benchmarks end by sleeping with interrupts off, which stops simavr; the timeout is for a hang
+timeout 300 simavr -m $MCU -f $F_CPU .pio/build/avr_bench/firmware.elf >"$output" 2>&1 || true
+if ! grep -q 'done' "$output"; then
+    echo "the benchmarks did not finish under simavr:" >&2
+    cat "$output" >&2
+    exit 1
+fi
+
+# simavr may put its own prefix in front of what the UART sent
+awk -v mcu=$MCU -v fcpu=$F_CPU -v flash="$flash" -v sram="$sram" -v benchFlash="$benchFlash" -v benchSram="$benchSram" '
+    BEGIN { n = 0 }
+    match($0, /cycles [^ ]+ [0-9]+ [0-9]+ [0-9]+/) {
+        split(substr($0, RSTART, RLENGTH), field, " ")
+        name[n] = field[2]; least[n] = field[3]; mean[n] = field[4]; most[n] = field[5]
+        n++
+    }
+    END {
+        print "{"
+        printf "  \"mcu\": \"%s\",\n  \"f_cpu\": %d,\n", mcu, fcpu
+        printf "  \"firmware\": {\"flash\": %d, \"sram\": %d},\n", flash, sram
+        printf "  \"bench_build\": {\"flash\": %d, \"sram\": %d},\n", benchFlash, benchSram
+        print "  \"cycles\": {"
+        for (i = 0; i < n; ++i) {
+            printf "    \"%s\": {\"least\": %d, \"mean\": %d, \"most\": %d}%s\n", name[i], least[i], mean[i], most[i],
+                   i < n - 1 ? "," : ""
+        }
+        print "  }"
+        print "}"
+    }' "$output" >"$current"
+
+# Every "name": {"key": value, ...} line as name.key; the previous results first, if there are any.
+compare='
+    function parse(line, into, order,   name, rest, count, pairs, pair, i) {
+        if (line !~ /^ *"[^"]+": \{.*\},?$/) return
+        name = line; sub(/^ *"/, "", name); sub(/".*/, "", name)
+        rest = line; sub(/^[^{]*\{/, "", rest); sub(/\}.*/, "", rest); gsub(/"/, "", rest)
+        count = split(rest, pairs, ", ")
+        for (i = 1; i <= count; ++i) {
+            split(pairs[i], pair, ": ")
+            into[name "." pair[1]] = pair[2]
+            if (order) keys[keyCount++] = name "." pair[1]
+        }
+    }
+    BEGIN { keyCount = 0 }
+    FILENAME == previous { parse($0, before, 0); next }
+    { parse($0, after, 1) }
+    END {
+        for (i = 0; i < keyCount; ++i) {
+            key = keys[i]
+            if (!(key in before)) {
+                printf "  %-44s %10s %10d  (new)\n", key, "", after[key]
+                changed++
+            } else if (before[key] != after[key]) {
+                printf "  %-44s %10d %10d  %+d (%+.1f%%)\n", key, before[key], after[key], after[key] - before[key],
+                       before[key] ? 100 * (after[key] - before[key]) / before[key] : 0
+                changed++
+            }
+        }
+        if (!changed) print "  nothing"
+    }'
+
+printf '%-10s %8d B flash %6d B SRAM (the benchmarks build: %d B, %d B)\n' firmware "$flash" "$sram" "$benchFlash" "$benchSram"
+printf '%-44s %10s %10s %10s\n' cycles least mean most
+awk 'match($0, /cycles [^ ]+ [0-9]+ [0-9]+ [0-9]+/) {
+    split(substr($0, RSTART, RLENGTH), field, " ")
+    printf "%-44s %10d %10d %10d\n", field[2], field[3], field[4], field[5]
+}' "$output"
+
+if [ -f "$results" ]; then
+    echo
+    echo "changed since $results was written:"
+    awk -v previous="$results" "$compare" "$results" "$current"
+fi
+mkdir -p "$(dirname "$results")"
+cp "$current" "$results"
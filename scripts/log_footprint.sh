@@ -0,0 +1,24 @@
+#!/usr/bin/env sh
+# Flash and SRAM of the firmware at each build-time log level, relative to LOG_LEVEL_NONE.
+# Builds the log_* environments from platformio.ini; run from anywhere inside the project.
+
+set -e
+cd "$(dirname "$0")/.."
+
+ENVS="log_none log_error log_warn log_info log_debug"
+
+for env in $ENVS; do
+    platformio run -s -e "$env" >/dev/null
+done
+
+printf '%-10s %8s %8s %8s %8s\n' level flash "+flash" sram "+sram"
+for env in $ENVS; do
+    elf=".pio/build/$env/firmware.elf"
+    # avr-size -A: .text + .data live in flash, .data + .bss in SRAM
+    set -- $(platformio pkg exec -p toolchain-atmelavr -- avr-size -A "$elf" | awk '
+        $1 == ".text" { text = $2 } $1 == ".data" { data = $2 } $1 == ".bss" { bss = $2 }
+        END { print text + data, data + bss }')
+    flash=$1 sram=$2
+    if [ -z "$baseFlash" ]; then baseFlash=$flash baseSram=$sram; fi
+    printf '%-10s %8d %8d %8d %8d\n' "${env#log_}" "$flash" $((flash - baseFlash)) "$sram" $((sram - baseSram))
+done
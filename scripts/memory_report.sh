@@ -0,0 +1,52 @@
+#!/usr/bin/env sh
+# SRAM budget of the firmware: .data and .bss from avr-size, the footprint table compiled into it
+# (memoryFootprint in src/main.cpp) and what is left for the stack once Program is allocated.
+# Builds the default environment, or the one given, from platformio.ini; run from anywhere inside
+# the project. At run time `mem` reports how much of that the stack has actually reached.
+
+set -e
+cd "$(dirname "$0")/.."
+
+# ATmega32U4
+SRAM=2560
+# avr-libc's size header in front of every malloc'd block
+MALLOC_HEADER=2
+
+env=${1:-sparkfun_promicro16}
+platformio run -s -e "$env" >/dev/null
+elf=".pio/build/$env/firmware.elf"
+tool() { platformio pkg exec -s -p toolchain-atmelavr -- "$@"; }
+
+set -- $(tool avr-size -A "$elf" | awk '$1 == ".data" { data = $2 } $1 == ".bss" { bss = $2 } END { print data + 0, bss + 0 }')
+data=$1 bss=$2
+
+# the table is in flash, at the same offset in a binary of .text: per entry an 8-byte name and a
+# little-endian u16 size
+set -- $(tool avr-nm -S "$elf" | awk '$4 == "memoryFootprint" { print $1, $2 }')
+if [ -z "$1" ]; then
+    echo "no memoryFootprint in $elf" >&2
+    exit 1
+fi
+text=$(mktemp)
+trap 'rm -f "$text"' EXIT
+tool avr-objcopy -O binary -j .text "$elf" "$text"
+
+footprint=$(od -An -v -tu1 -j $((0x$1)) -N $((0x$2)) "$text" | tr -s ' ' '\n' | awk '
+    NF { bytes[n++] = $1 }
+    END {
+        for (i = 0; i + 10 <= n; i += 10) {
+            name = ""
+            for (j = 0; j < 8 && bytes[i + j]; ++j) name = name sprintf("%c", bytes[i + j])
+            print name, bytes[i + 8] + 256 * bytes[i + 9]
+        }
+    }')
+program=$(echo "$footprint" | awk '$1 == "Program" { print $2 }')
+
+echo "sizeof, as laid out for the AVR:"
+echo "$footprint" | awk '{ printf "  %-10s %6d B\n", $1, $2 }'
+
+heap=$((program + MALLOC_HEADER))
+stack=$((SRAM - data - bss - heap))
+echo
+printf '%-24s %6d B\n' "SRAM" $SRAM ".data" "$data" ".bss" "$bss" "heap (new Program)" $heap
+printf '%-24s %6d B (%d%% of the SRAM)\n' "left for the stack" $stack $((stack * 100 / SRAM))
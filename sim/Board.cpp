@@ -0,0 +1,234 @@
+#include <Arduino.h>
+#include <Memory.h>
+#include <Sleep.h>
+#include <cstdarg>
+#include <cstdio>
+#include "Board.h"
+
+namespace sim {
+
+Board board;
+
+void Board::reset() {
+    *this = Board{};
+}
+
+void Board::setLevel(uint8_t pin, bool high) {
+    pin %= PIN_COUNT;
+    const bool wasHigh = pinLevels[pin];
+    pinLevels[pin] = high;
+    if (wasHigh == high || !pinInterrupts[pin]) return;
+
+    const auto mode = pinInterruptModes[pin];
+    if (mode == CHANGE || (mode == RISING && high) || (mode == FALLING && !high)) pinInterrupts[pin]();
+}
+
+void Board::receive(const char* data) {
+    if (*data && isRxWakeByteLost) ++data;
+    isRxWakeByteLost = false;
+    while (*data) rx.push_back((uint8_t)*data++);
+}
+
+void Board::sleep(const Wake& wake) {
+    if (!sleepEnabled || !wake.inMs) return;
+
+    if (exactSleep) {
+        auto wakeAt = micros + wake.inMs * 1000ULL;
+        if (nextPinChangeAt < wakeAt) wakeAt = nextPinChangeAt;
+        if (nextRxAt < wakeAt) wakeAt = nextRxAt;
+        if (wakeAt > micros) {
+            ++wakeUps;
+            idleMicros += wakeAt - micros;
+            micros = wakeAt;
+        }
+        return;
+    }
+
+    const auto isPowerDown = Sleep::modeFor(wake) == Sleep::POWER_DOWN;
+    auto wakeAt = isPowerDown
+            ? micros + Sleep::watchdogPeriodMs(Sleep::watchdogPeriodFor(wake.inMs)) * 1000
+            : (micros / 1000 + 1) * 1000;
+
+    // in idle every input interrupts, in power-down only the watched ones
+    auto isWokenByRx = false;
+    if ((!isPowerDown || (wake.sources & WAKE_PIN_CHANGE)) && nextPinChangeAt < wakeAt) wakeAt = nextPinChangeAt;
+    if ((!isPowerDown || (wake.sources & WAKE_SERIAL)) && nextRxAt < wakeAt) {
+        wakeAt = nextRxAt;
+        isWokenByRx = isPowerDown;
+    }
+    if (wakeAt < micros) wakeAt = micros;
+
+    ++wakeUps;
+    if (isPowerDown) {
+        powerDownMicros += wakeAt - micros;
+        micros = wakeAt + Sleep::POWER_DOWN_WAKE_UP_US;
+        isRxWakeByteLost = isWokenByRx;
+    } else {
+        idleMicros += wakeAt - micros;
+        micros = wakeAt;
+    }
+}
+
+void Board::logOutput(const char* format, ...) {
+    if (!outputLog) return;
+    char line[64];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    *outputLog += std::to_string(micros / 1000) + " " + line + "\n";
+    _txLineMs = UINT64_MAX;
+}
+
+void Board::setServoAttached(bool isAttached) {
+    if (isAttached && !servosAttached++) servoAttachedSince = micros;
+    if (!isAttached && servosAttached && !--servosAttached) servoAttachedMicros += micros - servoAttachedSince;
+}
+
+uint64_t Board::servoAttachedTime() const {
+    return servoAttachedMicros + (servosAttached ? micros - servoAttachedSince : 0);
+}
+
+int Board::txFree() const {
+    if (!hostAttached) return 0;
+    if (!pacedSerial || !baud || txDrainedAt <= micros) return SERIAL_TX_BUFFER_SIZE;
+    const auto pending = (txDrainedAt - micros + byteMicros() - 1) / byteMicros();
+    return pending >= SERIAL_TX_BUFFER_SIZE ? 0 : (int)(SERIAL_TX_BUFFER_SIZE - pending);
+}
+
+void Board::transmit(uint8_t value) {
+    if (pacedSerial && baud) {
+        if (!txFree()) {
+            const auto resumeAt = txDrainedAt - (SERIAL_TX_BUFFER_SIZE - 1) * byteMicros();
+            txStallMicros += resumeAt - micros;
+            micros = resumeAt;
+        }
+        txDrainedAt = (txDrainedAt > micros ? txDrainedAt : micros) + byteMicros();
+    }
+
+    tx.push_back((char)value);
+    if (outputLog) {
+        char hex[3];
+        snprintf(hex, sizeof(hex), "%02x", value);
+        // the bytes of one ms share a line
+        if (_txLineMs == micros / 1000) outputLog->insert(outputLog->size() - 1, hex);
+        else {
+            logOutput("tx %s", hex);
+            _txLineMs = micros / 1000;
+        }
+    }
+    if (echo) std::putchar(value);
+}
+
+}
+
+using sim::board;
+
+Serial_ Serial;
+USBDevice_ USBDevice;
+
+bool USBDevice_::configured() { return board.hostAttached; }
+
+void Sleep::watchPin(uint8_t) {}
+void Sleep::watchSerial(uint8_t) {}
+void Sleep::until(const Wake& wake) { board.sleep(wake); }
+// the virtual clock never stops, so there is nothing to catch up
+void Sleep::settle() {}
+// inputs arrive between passes, never while one decides to sleep
+void Sleep::noteInput() {}
+void Sleep::clearInput() {}
+
+// There is no SRAM to run out of on the host; the memory figures read as zero.
+uint16_t Memory::unusedStack() { return 0; }
+uint16_t Memory::freeNow() { return 0; }
+uint16_t Memory::freeHeap() { return 0; }
+uint16_t Memory::largestFreeBlock() { return 0; }
+
+unsigned long millis() { return (unsigned long)(board.localMicros() / 1000); }
+unsigned long micros() { return (unsigned long)board.localMicros(); }
+void delay(unsigned long ms) { board.advanceMs(ms); }
+void delayMicroseconds(unsigned int us) { board.advance(us); }
+
+void pinMode(uint8_t pin, uint8_t mode) { board.pinModes[pin % sim::Board::PIN_COUNT] = mode; }
+void digitalWrite(uint8_t pin, uint8_t value) {
+    if (board.level(pin) != (value != LOW)) board.logOutput("pin %u %u", pin, value != LOW);
+    board.setLevel(pin, value != LOW);
+}
+int digitalRead(uint8_t pin) { return board.level(pin) ? HIGH : LOW; }
+
+void attachInterrupt(uint8_t interrupt, void (*handler)(), int mode) {
+    board.pinInterrupts[interrupt % sim::Board::PIN_COUNT] = handler;
+    board.pinInterruptModes[interrupt % sim::Board::PIN_COUNT] = mode;
+}
+
+void detachInterrupt(uint8_t interrupt) { board.pinInterrupts[interrupt % sim::Board::PIN_COUNT] = nullptr; }
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t written = 0;
+    while (size--) written += write(*buffer++);
+    return written;
+}
+
+size_t Print::print(const char* value) { return write(value); }
+size_t Print::print(const String& value) { return write(value.c_str()); }
+size_t Print::print(char value) { return write((uint8_t)value); }
+size_t Print::print(unsigned char value, int base) { return print((unsigned long)value, base); }
+size_t Print::print(int value, int base) { return print((long)value, base); }
+size_t Print::print(unsigned int value, int base) { return print((unsigned long)value, base); }
+
+size_t Print::print(long value, int base) {
+    if (base == DEC && value < 0) return print('-') + printNumber(-(unsigned long)value, DEC);
+    return printNumber((unsigned long)value, base);
+}
+
+size_t Print::print(unsigned long value, int base) { return printNumber(value, base); }
+
+size_t Print::print(double value, int digits) {
+    char buffer[48];
+    snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+    return write(buffer);
+}
+
+size_t Print::println() { return write("\r\n"); }
+
+size_t Print::printNumber(unsigned long value, uint8_t base) {
+    if (base < 2) base = 10;
+    char buffer[8 * sizeof(long) + 1];
+    char* str = &buffer[sizeof(buffer) - 1];
+    *str = '\0';
+    do {
+        const auto digit = (char)(value % base);
+        value /= base;
+        *--str = (char)(digit < 10 ? digit + '0' : digit + 'A' - 10);
+    } while (value);
+    return write(str);
+}
+
+size_t Stream::readBytes(char* buffer, size_t length) {
+    size_t count = 0;
+    while (count < length && available() > 0) buffer[count++] = (char)read();
+    return count;
+}
+
+void Serial_::begin(unsigned long baud) { board.baud = baud; }
+
+int Serial_::available() { return (int)board.rx.size(); }
+
+int Serial_::read() {
+    if (board.rx.empty()) return -1;
+    const auto value = board.rx.front();
+    board.rx.pop_front();
+    return value;
+}
+
+int Serial_::peek() { return board.rx.empty() ? -1 : board.rx.front(); }
+
+int Serial_::availableForWrite() { return board.txFree(); }
+
+bool Serial_::dtr() { return board.hostAttached; }
+
+size_t Serial_::write(uint8_t value) {
+    if (!board.hostAttached) return 0;
+    board.transmit(value);
+    return 1;
+}
@@ -0,0 +1,74 @@
+#include <EEPROM.h>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "Board.h"
+
+namespace sim {
+
+Eeprom eeprom;
+
+Eeprom::Eeprom() { memset(memory, 0xFF, SIZE); }
+
+Eeprom::~Eeprom() {
+    if (_file < 0) return;
+    munmap(cells, SIZE);
+    close(_file);
+}
+
+bool Eeprom::map(const char* path) {
+    const auto file = open(path, O_RDWR | O_CREAT, 0644);
+    if (file < 0) return false;
+
+    struct stat status{};
+    const auto isNew = fstat(file, &status) == 0 && status.st_size < SIZE;
+    if (isNew && ftruncate(file, SIZE) != 0) {
+        close(file);
+        return false;
+    }
+    const auto mapped = mmap(nullptr, SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    if (mapped == MAP_FAILED) {
+        close(file);
+        return false;
+    }
+
+    _file = file;
+    cells = (uint8_t*)mapped;
+    if (isNew) erase();
+    return true;
+}
+
+void Eeprom::erase() { memset(cells, 0xFF, SIZE); }
+
+void Eeprom::resetCounters() {
+    memset(cycles, 0, sizeof(cycles));
+    reads = 0;
+    writes = 0;
+}
+
+}
+
+EEPROMClass EEPROM;
+
+uint8_t EEPROMClass::read(int address) {
+    sim::eeprom.reads++;
+    return sim::eeprom.cells[address % sim::Eeprom::SIZE];
+}
+
+void EEPROMClass::write(int address, uint8_t value) {
+    auto& eeprom = sim::eeprom;
+    if (!eeprom.writesUntilPowerLoss) return;
+    if (eeprom.writesUntilPowerLoss > 0) eeprom.writesUntilPowerLoss--;
+
+    address %= sim::Eeprom::SIZE;
+    eeprom.cells[address] = value;
+    eeprom.cycles[address]++;
+    eeprom.writes++;
+    sim::board.advance(sim::Eeprom::WRITE_US);
+}
+
+void EEPROMClass::update(int address, uint8_t value) {
+    if (read(address) != value) write(address, value);
+}
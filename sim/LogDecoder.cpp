@@ -0,0 +1,183 @@
+#include "LogDecoder.h"
+
+#include <Format.h>
+#include <Logger.h>
+
+#include <filesystem>
+#include <fstream>
+#include <regex>
+#include <sstream>
+
+namespace sim {
+
+namespace {
+
+std::string unescape(const std::string& literal) {
+    std::string result;
+    for (size_t i = 0; i < literal.size(); ++i) {
+        if (literal[i] == '\\' && i + 1 < literal.size()) {
+            const auto escaped = literal[++i];
+            result.push_back(escaped == 'n' ? '\n' : escaped == 't' ? '\t' : escaped);
+        } else result.push_back(literal[i]);
+    }
+    return result;
+}
+
+std::string hex(const uint8_t* data, size_t size) {
+    std::string result;
+    char byte[4];
+    for (size_t i = 0; i < size; ++i) {
+        snprintf(byte, sizeof(byte), i ? " %02x" : "%02x", data[i]);
+        result += byte;
+    }
+    return result;
+}
+
+struct Arg {
+    uint8_t kind;
+    uint32_t raw;
+    std::string text;
+
+    // As the firmware's Format would write it.
+    std::string format(const Format::Spec& spec) const {
+        char buffer[64];
+        Format::Writer writer{buffer, sizeof(buffer)};
+        if (kind == 2) Format::argument(writer, spec, text.c_str());
+        else if (kind == 1) Format::argument(writer, spec, (int32_t)raw);
+        else Format::argument(writer, spec, raw);
+        return buffer;
+    }
+};
+
+// Reads one tagged argument (see Logger.h); returns false when the record is cut short.
+bool readArg(const uint8_t*& data, const uint8_t* end, Arg& value) {
+    if (data == end) return false;
+    const uint8_t kind = *data >> 4, size = *data & 0x0F;
+    ++data;
+    if (end - data < size) return false;
+
+    value.kind = kind;
+    if (kind == 2) value.text.assign((const char*)data, size);
+    else {
+        uint32_t raw = 0;
+        for (uint8_t i = 0; i < size && i < 4; ++i) raw |= (uint32_t)data[i] << (8 * i);
+        if (kind == 1 && size < 4 && (raw >> (8 * size - 1)) & 1) raw |= ~0UL << (8 * size);
+        value.raw = raw;
+    }
+    data += size;
+    return true;
+}
+
+}
+
+void LogDecoder::add(const std::string& message) {
+    const auto id = logHash(message.c_str());
+    const auto existing = _messages.find(id);
+    if (existing != _messages.end() && existing->second != message) {
+        _collisions.push_back(existing->second + " / " + message);
+        return;
+    }
+    _messages[id] = message;
+}
+
+size_t LogDecoder::index(const std::string& root) {
+    static const std::regex literal(R"(LOG_(?:ERROR|WARN|INFO|DEBUG|ID)\s*\(\s*(?:\w+\s*,\s*)?"((?:[^"\\]|\\.)*)\")");
+
+    size_t count = 0;
+    std::error_code error;
+    for (std::filesystem::recursive_directory_iterator it(root, error), end; !error && it != end; it.increment(error)) {
+        const auto extension = it->path().extension();
+        if (extension != ".h" && extension != ".cpp" && extension != ".hpp") continue;
+
+        std::ifstream file(it->path());
+        std::stringstream contents;
+        contents << file.rdbuf();
+        const auto source = contents.str();
+        for (std::sregex_iterator match(source.begin(), source.end(), literal), last; match != last; ++match) {
+            add(unescape((*match)[1]));
+            ++count;
+        }
+    }
+    return count;
+}
+
+std::string LogDecoder::decode(const uint8_t* frame, size_t size) const {
+    if (size < BinaryProtocol::CRC_SIZE + 1) return "? short frame " + hex(frame, size);
+
+    const auto bodySize = size - BinaryProtocol::CRC_SIZE;
+    const uint16_t crc = frame[bodySize] | frame[bodySize + 1] << 8;
+    if (crc != BinaryProtocol::crc16(frame, bodySize)) return "? bad crc " + hex(frame, size);
+
+    const auto kind = frame[0];
+    if (kind & BinaryProtocol::RESPONSE_FLAG) {
+        if (bodySize < 3) return "? short response " + hex(frame, size);
+        char line[64];
+        snprintf(line, sizeof(line), "< opcode 0x%02x seq %u status %u", kind & ~BinaryProtocol::RESPONSE_FLAG, frame[1], frame[2]);
+        return std::string(line) + (bodySize > 3 ? " payload " + hex(frame + 3, bodySize - 3) : "");
+    }
+
+    if (kind == BinaryProtocol::TRACE_RECORD && bodySize >= 2) {
+        return "trace seq " + std::to_string(frame[1]) + ", " + std::to_string(bodySize - 2) + " bytes of input records";
+    }
+    if ((kind & 0xF0) != BinaryProtocol::LOG_RECORD || bodySize < 7) return "? unknown frame " + hex(frame, size);
+
+    static const char levels[] = "?ewid";
+    const auto level = kind & 0x0F;
+    const uint32_t timestamp = frame[1] | frame[2] << 8 | frame[3] << 16 | (uint32_t)frame[4] << 24;
+    const uint16_t id = frame[5] | frame[6] << 8;
+
+    std::vector<Arg> args;
+    const uint8_t* data = frame + 7;
+    const uint8_t* end = frame + bodySize;
+    Arg arg{};
+    while (data < end && readArg(data, end, arg)) args.push_back(arg);
+
+    const auto message = _messages.find(id);
+    std::string text;
+    size_t next = 0;
+    if (message == _messages.end()) {
+        char unknown[16];
+        snprintf(unknown, sizeof(unknown), "#%04x", id);
+        text = unknown;
+    } else {
+        const char* format = message->second.c_str();
+        while (*format) {
+            Format::Spec spec;
+            const char* after = *format == '{' && next < args.size() ? Format::parseSpec(format + 1, spec) : nullptr;
+            if (!after) {
+                text.push_back(*format++);
+                continue;
+            }
+            text += args[next++].format(spec);
+            format = after;
+        }
+    }
+    for (; next < args.size(); ++next) text += " " + args[next].format(Format::Spec{});
+
+    return std::string(1, level < 5 ? levels[level] : '?') + "/" + std::to_string(timestamp) + "/" + text;
+}
+
+void LogDecoder::feed(const uint8_t* data, size_t size, const LineHandler& onLine) {
+    for (size_t i = 0; i < size; ++i) {
+        const auto value = data[i];
+        if (value == BinaryProtocol::FRAME_DELIMITER) {
+            if (_isInFrame && !_frame.empty()) {
+                const auto length = BinaryProtocol::decode(_frame.data(), _frame.size());
+                onLine(length ? decode(_frame.data(), length) : "? bad cobs " + hex(_frame.data(), _frame.size()));
+                _isInFrame = false;
+            } else {
+                if (!_text.empty()) onLine(_text);
+                _text.clear();
+                _isInFrame = true;
+            }
+            _frame.clear();
+        } else if (_isInFrame) {
+            _frame.push_back(value);
+        } else if (value == '\n' || value == '\r') {
+            if (!_text.empty()) onLine(_text);
+            _text.clear();
+        } else _text.push_back((char)value);
+    }
+}
+
+}
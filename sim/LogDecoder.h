@@ -0,0 +1,42 @@
+#pragma once
+
+// Host side of the tokenized logger: maps message hashes back to the literals found in the sources
+// and turns the serial byte stream (log records, command responses, stray text) into readable lines.
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace sim {
+
+class LogDecoder {
+public:
+    typedef std::function<void(const std::string&)> LineHandler;
+
+    // Indexes every LOG_*("...") and LOG_ID("...") literal in C/C++ sources under `root`.
+    size_t index(const std::string& root);
+    void add(const std::string& message);
+
+    void feed(const uint8_t* data, size_t size, const LineHandler& onLine);
+    void feed(const std::string& data, const LineHandler& onLine) {
+        feed((const uint8_t*)data.data(), data.size(), onLine);
+    }
+
+    // `frame` is the COBS-decoded content of one frame, CRC included.
+    std::string decode(const uint8_t* frame, size_t size) const;
+
+    // Messages that share a hash with another one; their records cannot be told apart.
+    const std::vector<std::string>& collisions() const { return _collisions; }
+
+private:
+    std::map<uint16_t, std::string> _messages;
+    std::vector<std::string> _collisions;
+
+    std::vector<uint8_t> _frame;
+    std::string _text;
+    bool _isInFrame = false;
+};
+
+}
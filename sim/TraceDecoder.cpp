@@ -0,0 +1,106 @@
+#include "TraceDecoder.h"
+
+#include <BinaryProtocol.h>
+#include <InputTrace.h>
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace sim {
+
+namespace {
+
+typedef InputTrace<1> Trace;
+
+}
+
+TraceDecoder::TraceDecoder() { memset(eeprom, 0xFF, sizeof(eeprom)); }
+
+bool TraceDecoder::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    const std::vector<uint8_t> data{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    feed(data.data(), data.size());
+    return true;
+}
+
+void TraceDecoder::feed(const uint8_t* data, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        const auto value = data[i];
+        if (value != BinaryProtocol::FRAME_DELIMITER) {
+            if (_isInFrame) _frame.push_back(value);
+            continue;
+        }
+        if (_isInFrame && !_frame.empty()) {
+            const auto length = BinaryProtocol::decode(_frame.data(), _frame.size());
+            if (length) decode(_frame.data(), length);
+            else if (_frame[0] == BinaryProtocol::TRACE_RECORD) badFrames++;
+            _isInFrame = false;
+        } else _isInFrame = true;
+        _frame.clear();
+    }
+}
+
+void TraceDecoder::decode(const uint8_t* frame, size_t size) {
+    if (size < 2 + BinaryProtocol::CRC_SIZE || frame[0] != BinaryProtocol::TRACE_RECORD) return;
+
+    const auto bodySize = size - BinaryProtocol::CRC_SIZE;
+    const uint16_t crc = frame[bodySize] | frame[bodySize + 1] << 8;
+    if (crc != BinaryProtocol::crc16(frame, bodySize)) {
+        badFrames++;
+        return;
+    }
+
+    const auto sequence = frame[1];
+    if (_hasSequence) missingFrames += (uint8_t)(sequence - _nextSequence);
+    _hasSequence = true;
+    _nextSequence = sequence + 1;
+    decodeRecords(frame + 2, frame + bodySize);
+}
+
+void TraceDecoder::decodeRecords(const uint8_t* data, const uint8_t* end) {
+    while (data < end) {
+        uint32_t header = 0;
+        for (uint8_t shift = 0; data < end; shift += 7) {
+            const auto value = *data++;
+            header |= (uint32_t)(value & 0x7F) << shift;
+            if (!(value & 0x80)) break;
+        }
+
+        _atMs += header >> 2;
+        const auto kind = header & 0b11;
+        if (data == end) {
+            badFrames++;
+            return;
+        }
+
+        if (kind == Trace::SERIAL_BYTE) {
+            inputs.push_back({_atMs, Input::SERIAL, 0, *data++});
+        } else if (kind == Trace::PIN_LEVEL) {
+            inputs.push_back({_atMs, Input::PIN, (uint8_t)(*data >> 1), (uint8_t)(*data & 1)});
+            data++;
+        } else if (kind == Trace::SNAPSHOT && *data & Trace::SNAPSHOT_PIN) {
+            bootLevels.push_back({(uint8_t)((*data & ~Trace::SNAPSHOT_PIN) >> 1), (bool)(*data & 1)});
+            data++;
+        } else if (kind == Trace::SNAPSHOT) {
+            const auto address = *data++ * Trace::SNAPSHOT_CHUNK;
+            if (end - data < Trace::SNAPSHOT_CHUNK || address + Trace::SNAPSHOT_CHUNK > Eeprom::SIZE) {
+                badFrames++;
+                return;
+            }
+            memcpy(eeprom + address, data, Trace::SNAPSHOT_CHUNK);
+            eepromBytes += Trace::SNAPSHOT_CHUNK;
+            data += Trace::SNAPSHOT_CHUNK;
+        } else {
+            if (end - data < 2) {
+                badFrames++;
+                return;
+            }
+            lostRecords += data[0] | data[1] << 8;
+            data += 2;
+        }
+    }
+}
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+// Host side of InputTrace: picks the TRACE_RECORD frames out of a serial capture and turns their
+// records back into what the firmware started from and the inputs it saw, at their ms.
+
+#include <EEPROM.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sim {
+
+class TraceDecoder {
+public:
+    struct Input {
+        enum Kind { SERIAL, PIN };
+
+        uint64_t atMs;
+        Kind kind;
+        uint8_t pin;
+        // the byte read, or the pin level
+        uint8_t value;
+    };
+
+    struct BootLevel {
+        uint8_t pin;
+        bool isHigh;
+    };
+
+    uint8_t eeprom[Eeprom::SIZE];
+    uint16_t eepromBytes = 0;
+    std::vector<BootLevel> bootLevels;
+    std::vector<Input> inputs;
+
+    // Frames missing from the sequence, frames that did not decode, and records the firmware
+    // reported lost to a full buffer.
+    uint32_t missingFrames = 0;
+    uint32_t badFrames = 0;
+    uint32_t lostRecords = 0;
+
+    TraceDecoder();
+
+    // Everything else on the line (log records, responses, text) is skipped.
+    void feed(const uint8_t* data, size_t size);
+    // Feeds the whole of a capture file; false if it cannot be read.
+    bool load(const std::string& path);
+
+    bool hasEeprom() const { return eepromBytes == Eeprom::SIZE; }
+
+private:
+    std::vector<uint8_t> _frame;
+    bool _isInFrame = false;
+    bool _hasSequence = false;
+    uint8_t _nextSequence = 0;
+    uint64_t _atMs = 0;
+
+    void decode(const uint8_t* frame, size_t size);
+    void decodeRecords(const uint8_t* data, const uint8_t* end);
+};
+
+}
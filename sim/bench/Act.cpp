@@ -0,0 +1,65 @@
+// Program's components run through the compile-time ComponentList against the same components
+// behind a list of IReact pointers, the way a virtual design runs them: host cycles for the
+// react() calls of an idle pass, for merging the wakes, and for a whole idle act().
+
+#define LOG_LEVEL LOG_LEVEL_NONE
+#include "../../src/main.cpp"
+#include "Bench.h"
+
+#include <type_traits>
+
+namespace {
+
+struct IReact {
+    virtual void react() = 0;
+    virtual Wake nextWake() const = 0;
+};
+
+template<typename T> struct Virtual: IReact {
+    T& component;
+    explicit Virtual(T& component): component{component} {}
+    void react() override { component.react(); }
+    Wake nextWake() const override { return component.nextWake(); }
+};
+
+static_assert(!std::is_polymorphic<decltype(Program::rotatorButton)>::value, "Button has a vtable");
+static_assert(!std::is_polymorphic<decltype(Program::servoRotator)>::value, "ServoRotator has a vtable");
+static_assert(!std::is_polymorphic<decltype(Program::jobsScheduler)>::value, "DayJobsScheduler has a vtable");
+static_assert(!std::is_polymorphic<decltype(Program::store)>::value, "ScheduleStore has a vtable");
+static_assert(!std::is_polymorphic<decltype(Program::streamListener)>::value, "StreamListener has a vtable");
+
+}
+
+int main() {
+    const uint64_t iterations = 5000000;
+    setup();
+
+    Virtual<decltype(Program::rotatorButton)> button{program->rotatorButton};
+    Virtual<decltype(Program::servoRotator)> servo{program->servoRotator};
+    Virtual<decltype(Program::jobsScheduler)> scheduler{program->jobsScheduler};
+    Virtual<decltype(Program::store)> store{program->store};
+    Virtual<decltype(Program::streamListener)> listener{program->streamListener};
+    IReact* components[] = {&button, &servo, &scheduler, &store, &listener};
+    // the calls must not be resolved at compile time
+    IReact** list = components;
+    bench::keep(list);
+
+    printf("%u components, wake sources 0x%02x, shortest period %u ms; Program %zu bytes on the host\n",
+           Program::Components::COUNT, Program::Components::WAKE_SOURCES, Program::Components::PERIOD_MS,
+           sizeof(Program));
+
+    bench::run("react, IReact list", iterations, [&] {
+        for (uint8_t i = 0; i < 5; ++i) list[i]->react();
+    });
+    bench::run("react, ComponentList", iterations, [&] { Program::Components::react(*program); });
+
+    bench::run("nextWake, IReact list", iterations, [&] {
+        Wake wake{Wake::NEVER};
+        for (uint8_t i = 0; i < 5; ++i) wake = wake.earliest(list[i]->nextWake());
+        bench::keep(wake);
+    });
+    bench::run("nextWake, ComponentList", iterations, [&] { bench::keep(Program::Components::nextWake(*program)); });
+
+    bench::run("act(), idle", iterations, [&] { program->act(); });
+    return 0;
+}
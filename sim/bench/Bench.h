@@ -0,0 +1,49 @@
+#pragma once
+
+// Minimal host microbenchmark helpers. Cycle counts come from the time-stamp counter where there is
+// one, so they are host cycles: compare before/after on the same machine, not against the AVR.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace bench {
+
+inline uint64_t cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+template<typename T> inline void keep(const T& value) { asm volatile("" : : "g"(&value) : "memory"); }
+
+struct Result {
+    double nsPerOp;
+    double cyclesPerOp;
+};
+
+template<typename TFn> Result run(const char* name, uint64_t iterations, TFn fn) {
+    for (uint64_t i = 0; i < iterations / 10; ++i) fn();
+
+    const auto wallStart = std::chrono::steady_clock::now();
+    const auto cyclesStart = cycles();
+    for (uint64_t i = 0; i < iterations; ++i) fn();
+    const auto cyclesTaken = cycles() - cyclesStart;
+    const auto wallTaken = std::chrono::steady_clock::now() - wallStart;
+
+    const Result result{
+            std::chrono::duration<double, std::nano>(wallTaken).count() / iterations,
+            (double)cyclesTaken / iterations
+    };
+    printf("%-44s %10.2f ns/op %10.1f cycles/op\n", name, result.nsPerOp, result.cyclesPerOp);
+    return result;
+}
+
+}
@@ -0,0 +1,217 @@
+// The in-place Component (dirty bits, bounded renders) against the copying template it replaced,
+// both assembling lines from the stream (the in-place side is StreamListener as it is now, bulk
+// reads and all): host cycles per react() with and without input, and how deep the stack is when
+// the line is handed over.
+
+#define LOG_LEVEL LOG_LEVEL_NONE
+#include "../../src/main.cpp"
+#include "Bench.h"
+
+namespace {
+
+struct IReact {
+    virtual void react() = 0;
+};
+
+// The previous engine: props, state and the next state copied on every react() and every pass.
+template<typename TProps, typename TState>
+struct CopyingComponent: IReact {
+    TProps props;
+    TState state;
+
+    CopyingComponent(): props{}, state{} {}
+
+    virtual void componentDidUpdate(const TProps& prevProps, const TState& prevState, TState& nextState, bool& shouldUpdate) = 0;
+    virtual void updateProps(TProps& nextProps, bool& shouldUpdate) = 0;
+
+    void react() override {
+        bool shouldUpdate = false;
+        auto prevProps = props;
+        updateProps(props, shouldUpdate);
+        auto nextState = state;
+        while (shouldUpdate) {
+            shouldUpdate = false;
+            auto prevState = state;
+            state = nextState;
+            componentDidUpdate(prevProps, prevState, nextState, shouldUpdate);
+            prevProps = props;
+        }
+    }
+};
+
+// StreamListener's state as it was then.
+template<uint8_t bufferSize>
+struct CopyingStreamListenerState {
+    InlineVector<char, bufferSize> buffer{};
+    bool shouldSendData = false;
+    bool isFrame = false;
+    bool isFrameOverflowed = false;
+};
+
+// StreamListener as it was written for CopyingComponent.
+template<typename TContext, uint8_t bufferSize = 20>
+struct CopyingStreamListener: CopyingComponent<StreamListenerProps<bufferSize>, CopyingStreamListenerState<bufferSize>> {
+    CopyingStreamListener(TContext& context, Stream& stream, void(*onInput)(const char*, TContext&)):
+        _context{context}, _stream{stream}, _onInput{onInput} {}
+
+    void updateProps(StreamListenerProps<bufferSize>& nextProps, bool& shouldUpdate) override {
+        shouldUpdate = _stream.available() > 0;
+    }
+
+    void componentDidUpdate(
+            const StreamListenerProps<bufferSize>& prevProps,
+            const CopyingStreamListenerState<bufferSize>& prevState,
+            CopyingStreamListenerState<bufferSize>& nextState,
+            bool& shouldUpdate
+        ) override {
+        if (this->state.shouldSendData) {
+            nextState.shouldSendData = false;
+            if (this->state.isFrame) onFrame((uint8_t*)(this->state.buffer.data()), this->state.buffer.size());
+            else onInput(this->state.buffer.data());
+            nextState.buffer = InlineVector<char, bufferSize>{};
+            nextState.isFrame = false;
+            shouldUpdate = true;
+        }
+
+        if (_stream.available() > 0) {
+            bool hasBeenTerminated = false;
+            bool hasFrameEnded = false;
+
+            while (_stream.available() > 0) {
+                const char currentChar = _stream.read();
+
+                if (_onFrame && currentChar == FRAME_DELIMITER) {
+                    if (nextState.isFrame && !nextState.buffer.isEmpty()) {
+                        if (!nextState.isFrameOverflowed) {
+                            hasFrameEnded = true;
+                            break;
+                        }
+                        nextState.isFrame = false;
+                    } else nextState.isFrame = true;
+
+                    nextState.buffer = InlineVector<char, bufferSize>{};
+                    nextState.isFrameOverflowed = false;
+                    continue;
+                }
+
+                if (nextState.isFrame) {
+                    if (!nextState.buffer.add(currentChar)) nextState.isFrameOverflowed = true;
+                    continue;
+                }
+
+                auto iter = _terminatingCharacters;
+                while (*iter) if (currentChar == *(iter++)) hasBeenTerminated = true;
+                if (hasBeenTerminated) {
+                    if (nextState.buffer.isEmpty()) {
+                        hasBeenTerminated = false;
+                        continue;
+                    }
+                    break;
+                }
+
+                const auto isAddSuccess = nextState.buffer.add(currentChar);
+                if (!isAddSuccess) {
+                    break;
+                }
+            }
+
+            if (hasFrameEnded) {
+                nextState.shouldSendData = true;
+            } else if (!nextState.isFrame && (this->state.buffer.isFull() || hasBeenTerminated)) {
+                if (this->state.buffer.isFull()) {
+                    nextState.buffer.back() = '\0';
+                } else if (hasBeenTerminated) {
+                    if (! nextState.buffer.add('\0')) nextState.buffer.back() = '\0';
+                }
+
+                nextState.shouldSendData = true;
+            }
+
+            shouldUpdate = true;
+        }
+    }
+
+private:
+    static const char FRAME_DELIMITER = BinaryProtocol::FRAME_DELIMITER;
+
+    TContext& _context;
+    Stream& _stream;
+    const char* _terminatingCharacters = "\r\n";
+
+    void (*_onInput)(const char*, TContext&);
+    void onInput(const char* value) { if (_onInput) _onInput(value, _context); }
+
+    void (*_onFrame)(uint8_t*, uint8_t, TContext&) = nullptr;
+    void onFrame(uint8_t* frame, uint8_t length) { if (_onFrame) _onFrame(frame, length, _context); }
+};
+
+// Hands out `pending` bytes of a command line, over and over.
+struct ScriptStream: Stream {
+    const char* line = "scj,12,30,0\n";
+    uint8_t position = 0;
+    uint8_t pending = 0;
+
+    int available() override { return pending; }
+    int peek() override { return pending ? line[position] : -1; }
+    int read() override {
+        if (!pending) return -1;
+        pending--;
+        const char value = line[position++];
+        if (!line[position]) position = 0;
+        return value;
+    }
+    size_t write(uint8_t) override { return 1; }
+    using Print::write;
+};
+
+struct Context {
+    const uint8_t* reactFrame = nullptr;
+    size_t deepestStack = 0;
+    uint32_t lines = 0;
+};
+
+void onLine(const char* line, Context& context) {
+    const auto depth = (size_t)(context.reactFrame - (const uint8_t*)__builtin_frame_address(0));
+    if (depth > context.deepestStack) context.deepestStack = depth;
+    context.lines++;
+    bench::keep(line);
+}
+
+template<typename TListener>
+void measure(const char* name, TListener& listener, ScriptStream& stream, Context& context) {
+    const uint64_t iterations = 5000000;
+    char label[64];
+
+    snprintf(label, sizeof(label), "%s, idle", name);
+    bench::run(label, iterations, [&] { listener.react(); });
+
+    snprintf(label, sizeof(label), "%s, one line per react", name);
+    bench::run(label, iterations, [&] {
+        stream.pending = 12;
+        listener.react();
+    });
+
+    context.reactFrame = (const uint8_t*)__builtin_frame_address(0);
+    context.deepestStack = 0;
+    stream.pending = 12;
+    listener.react();
+    listener.react();
+    printf("%-44s %10zu bytes below the caller's frame\n", "  stack at onInput", context.deepestStack);
+}
+
+}
+
+int main() {
+    ScriptStream copyingStream, inPlaceStream;
+    Context copyingContext, inPlaceContext;
+
+    CopyingStreamListener<Context> copying{copyingContext, copyingStream, onLine};
+    StreamListener<Context> inPlace{inPlaceContext, inPlaceStream, onLine};
+
+    printf("state copied per pass: %zu bytes of state, %zu of props\n",
+           sizeof(CopyingStreamListenerState<20>), sizeof(StreamListenerProps<20>));
+    measure("copying Component", copying, copyingStream, copyingContext);
+    measure("in-place Component", inPlace, inPlaceStream, inPlaceContext);
+    printf("lines handled: %u / %u\n", copyingContext.lines, inPlaceContext.lines);
+    return 0;
+}
@@ -0,0 +1,324 @@
+// The fixed-capacity containers of lib/FixedContainers against the StaticArray/Array/Set templates
+// they replaced: the line buffer of StreamListener, the scheduler's job table at 10 and 32 jobs
+// (insert in order, look up, unschedule and schedule again, walk), a byte ring as Logger and
+// InputTrace keep one, and unlinking from a list. Object sizes are the host's.
+
+#define LOG_LEVEL LOG_LEVEL_NONE
+#include "../../src/main.cpp"
+#include "Bench.h"
+
+namespace {
+
+template<typename T> struct IEquatable { virtual bool equals(const T*) const = 0; };
+
+// The previous templates, as they were.
+template<typename TItem, uint8_t SIZE> struct StaticArray {
+    TItem list[SIZE]{};
+    uint8_t count = 0;
+    uint8_t size = SIZE;
+
+    virtual bool add(TItem item) {
+        if (count == SIZE) return false;
+
+        list[count++] = item;
+        return true;
+    }
+
+    bool set(int16_t index, TItem item) {
+        if (index < 0 || index >= count) return false;
+        list[index] = item;
+        return true;
+    }
+
+    void clear() { count = 0; }
+};
+
+template<typename TItem, unsigned short SIZE> struct Array {
+    TItem* list[SIZE]{};
+    unsigned short count = 0;
+    const unsigned short size = SIZE;
+
+    virtual bool add(TItem *item) {
+        if (count == SIZE) return false;
+
+        list[count++] = item;
+        return true;
+    }
+
+    bool insertAt(int index, TItem* item) {
+        if (count == SIZE || index < 0 || index > count) return false;
+        for (unsigned short i = count; i > index; --i) {
+            list[i] = list[i - 1];
+        }
+        list[index] = item;
+        count++;
+        return true;
+    }
+
+    bool removeAt(int index) {
+        if (!count || index < 0 || index >= count) return false;
+        for (unsigned short i = index; i < count; ++i) {
+            list[i] = at(i + 1);
+        }
+        count--;
+        return true;
+    }
+
+    TItem* at(int index) const {
+        if (index < 0 || index >= count) return nullptr;
+
+        return list[index];
+    }
+
+    long indexOf(const IEquatable<TItem>* item) const {
+        for (unsigned short i = 0; i < count; ++i) {
+            const auto currentItem = list[i];
+            if (item->equals(currentItem)) return i;
+        }
+        return -1;
+    }
+
+    TItem* find(IEquatable<TItem>* item) {
+        for (unsigned int i = 0; i < count; ++i) {
+            const auto current = list[i];
+            if (item->equals(current)) return current;
+        }
+
+        return nullptr;
+    }
+};
+
+template<typename TItem, unsigned int size> struct Set: Array<TItem, size> {
+    bool add(TItem *item) override {
+        if (Array<TItem, size>::count == size) return false;
+        if (Array<TItem, size>::find(item)) return false;
+
+        return Array<TItem, size>::add(item);
+    }
+};
+
+struct OldJob final: IEquatable<OldJob> {
+    uint32_t ms;
+    uint32_t rule;
+    OldJob(uint32_t ms, uint32_t rule): ms{ms}, rule{rule} {}
+    bool equals(const OldJob* other) const override { return ms == other->ms && rule == other->rule; }
+};
+
+struct Job {
+    uint32_t ms;
+    uint32_t rule;
+
+    struct Order {
+        static bool less(const Job* a, const Job* b) { return a->ms < b->ms || (a->ms == b->ms && a->rule < b->rule); }
+    };
+};
+
+// The job table as the scheduler kept it in a Set: a linear duplicate check, a binary search by
+// time, and the shift.
+template<unsigned int CAPACITY> struct OldTable {
+    Set<OldJob, CAPACITY> jobs;
+
+    bool schedule(OldJob* job) {
+        if (jobs.count == CAPACITY || jobs.find(job)) return false;
+        unsigned short low = 0, high = jobs.count;
+        while (low < high) {
+            const unsigned short middle = (low + high) / 2;
+            if (jobs.at(middle)->ms < job->ms) low = middle + 1;
+            else high = middle;
+        }
+        return jobs.insertAt(low, job);
+    }
+
+    bool unschedule(OldJob* job) { return jobs.removeAt(jobs.indexOf(job)); }
+
+    uint32_t walk() const {
+        uint32_t sum = 0;
+        for (unsigned short i = 0; i < jobs.count; ++i) sum += jobs.at(i)->ms;
+        return sum;
+    }
+};
+
+template<uint8_t CAPACITY> struct Table {
+    SortedSet<Job*, CAPACITY, Job::Order> jobs;
+
+    bool schedule(Job* job) { return jobs.add(job); }
+    bool unschedule(Job* job) { return jobs.remove(job); }
+
+    uint32_t walk() const {
+        uint32_t sum = 0;
+        for (const auto job : jobs) sum += job->ms;
+        return sum;
+    }
+};
+
+// A ring of bytes the way Logger and InputTrace kept theirs.
+template<uint8_t CAPACITY> struct OldRing {
+    uint8_t buffer[CAPACITY]{};
+    uint8_t head = 0;
+    uint8_t used = 0;
+
+    bool push(uint8_t value) {
+        if (used == CAPACITY) return false;
+        buffer[(head + used) % CAPACITY] = value;
+        used++;
+        return true;
+    }
+
+    uint8_t at(uint8_t offset) const { return buffer[(head + offset) % CAPACITY]; }
+
+    void pop(uint8_t count) {
+        head = (head + count) % CAPACITY;
+        used -= count;
+    }
+};
+
+struct Node: IntrusiveList<Node>::Link {
+    uint32_t value = 0;
+};
+
+// Job times spread over the day, shuffled so that inserts land all over the table.
+template<uint8_t COUNT> void jobTimes(uint32_t (&ms)[COUNT]) {
+    for (uint8_t i = 0; i < COUNT; ++i) ms[i] = (uint32_t)((i * 7919UL) % COUNT) * (Time::DAY_MS / COUNT);
+}
+
+template<uint8_t COUNT> void benchTables(uint64_t iterations) {
+    uint32_t ms[COUNT];
+    jobTimes(ms);
+    OldJob* oldJobs[COUNT];
+    Job jobs[COUNT];
+    for (uint8_t i = 0; i < COUNT; ++i) {
+        oldJobs[i] = new OldJob(ms[i], 0);
+        jobs[i] = Job{ms[i], 0};
+    }
+
+    printf("\njob table, %u jobs\n", COUNT);
+    bench::run("  Set        schedule all", iterations, [&] {
+        OldTable<COUNT> table;
+        for (const auto job : oldJobs) table.schedule(job);
+        bench::keep(table);
+    });
+    bench::run("  SortedSet  schedule all", iterations, [&] {
+        Table<COUNT> table;
+        for (auto& job : jobs) table.schedule(&job);
+        bench::keep(table);
+    });
+
+    OldTable<COUNT> oldTable;
+    Table<COUNT> table;
+    for (const auto job : oldJobs) oldTable.schedule(job);
+    for (auto& job : jobs) table.schedule(&job);
+
+    uint8_t next = 0;
+    bench::run("  Set        unschedule and schedule one", iterations, [&] {
+        const auto job = oldJobs[next++ % COUNT];
+        oldTable.unschedule(job);
+        oldTable.schedule(job);
+    });
+    next = 0;
+    bench::run("  SortedSet  unschedule and schedule one", iterations, [&] {
+        const auto job = &jobs[next++ % COUNT];
+        table.unschedule(job);
+        table.schedule(job);
+    });
+
+    OldJob oldMissing{1, 1};
+    Job missing{1, 1};
+    bench::run("  Set        look up a job it does not hold", iterations, [&] { bench::keep(oldTable.jobs.find(&oldMissing)); });
+    bench::run("  SortedSet  look up a job it does not hold", iterations, [&] { bench::keep(table.jobs.contains(&missing)); });
+
+    bench::run("  Set        walk", iterations, [&] { bench::keep(oldTable.walk()); });
+    bench::run("  SortedSet  walk", iterations, [&] { bench::keep(table.walk()); });
+
+    for (const auto job : oldJobs) delete job;
+}
+
+}
+
+int main() {
+    const uint64_t iterations = 2000000;
+    const char line[] = "scj,7,30,0";
+
+    printf("line buffer, \"%s\" added and cleared\n", line);
+    StaticArray<char, 20> oldBuffer;
+    InlineVector<char, 20> buffer;
+    bench::run("  StaticArray", iterations, [&] {
+        for (const auto value : line) oldBuffer.add(value);
+        bench::keep(oldBuffer);
+        oldBuffer.clear();
+    });
+    bench::run("  InlineVector", iterations, [&] {
+        for (const auto value : line) buffer.add(value);
+        bench::keep(buffer);
+        buffer.clear();
+    });
+
+    benchTables<10>(iterations);
+    benchTables<32>(iterations / 4);
+
+    printf("\nbyte ring of 128, 40 pushed, read back and dropped\n");
+    OldRing<128> oldRing;
+    RingBuffer<uint8_t, 128> ring;
+    bench::run("  % CAPACITY", iterations, [&] {
+        for (uint8_t i = 0; i < 40; ++i) oldRing.push(i);
+        uint8_t sum = 0;
+        for (uint8_t i = 0; i < 40; ++i) sum += oldRing.at(i);
+        oldRing.pop(40);
+        bench::keep(sum);
+    });
+    bench::run("  RingBuffer", iterations, [&] {
+        for (uint8_t i = 0; i < 40; ++i) ring.push(i);
+        uint8_t sum = 0;
+        for (const auto value : ring) sum += value;
+        ring.pop(40);
+        bench::keep(sum);
+    });
+    OldRing<100> oldOddRing;
+    bench::run("  % CAPACITY of 100", iterations, [&] {
+        for (uint8_t i = 0; i < 40; ++i) oldOddRing.push(i);
+        uint8_t sum = 0;
+        for (uint8_t i = 0; i < 40; ++i) sum += oldOddRing.at(i);
+        oldOddRing.pop(40);
+        bench::keep(sum);
+    });
+    RingBuffer<uint8_t, 100> oddRing;
+    bench::run("  RingBuffer of 100", iterations, [&] {
+        for (uint8_t i = 0; i < 40; ++i) oddRing.push(i);
+        uint8_t sum = 0;
+        for (const auto value : oddRing) sum += value;
+        oddRing.pop(40);
+        bench::keep(sum);
+    });
+
+    printf("\n32 elements, one after the other removed and put back at the end\n");
+    uint32_t values[32];
+    Array<uint32_t, 32> array;
+    Node nodes[32];
+    IntrusiveList<Node> list;
+    for (uint8_t i = 0; i < 32; ++i) {
+        values[i] = i;
+        array.add(&values[i]);
+        nodes[i].value = i;
+        list.pushBack(nodes[i]);
+    }
+    uint8_t next = 0;
+    bench::run("  Array", iterations, [&] {
+        const auto index = next++ % 32;
+        const auto item = array.at(index);
+        array.removeAt(index);
+        array.add(item);
+        bench::keep(array);
+    });
+    next = 0;
+    bench::run("  IntrusiveList", iterations, [&] {
+        auto& node = nodes[next++ % 32];
+        list.remove(node);
+        list.pushBack(node);
+        bench::keep(list);
+    });
+
+    printf("\nsizes (host): StaticArray<char, 20> %zu B, InlineVector<char, 20> %zu B; "
+           "Set<job, 10> %zu B, SortedSet<job*, 10> %zu B\n",
+           sizeof(StaticArray<char, 20>), sizeof(InlineVector<char, 20>),
+           sizeof(Set<OldJob, 10>), sizeof(SortedSet<Job*, 10, Job::Order>));
+    return 0;
+}
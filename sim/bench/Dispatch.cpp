@@ -0,0 +1,125 @@
+// Dispatch latency of the compile-time command table against the strcmp chain it replaced,
+// for the four feeder commands and for a table of 32 commands. Handlers are no-ops and logging
+// is off, so the numbers are tokenizing, matching and argument parsing only.
+
+#define LOG_LEVEL LOG_LEVEL_NONE
+#include "../../src/main.cpp"
+#include "Bench.h"
+
+namespace {
+
+struct Context {};
+
+uint8_t noop(const uint32_t* args, CommandResponse*, Context&) {
+    bench::keep(args[0]);
+    return BinaryProtocol::OK;
+}
+
+// The previous interpreter: a copy of the line split in place, strtol and a strcmp per command.
+struct ChainInterpreter {
+    static const uint8_t BUFFER_SIZE = 20;
+
+    const char* const* names;
+    uint8_t count;
+
+    static void split(char* input, uint8_t maxCount, char* output[]) {
+        uint8_t outputCount = 0;
+        output[outputCount++] = input;
+        for (int16_t i = 0; input[i] && outputCount < maxCount; ++i) {
+            if (input[i] == ',') {
+                input[i] = '\0';
+                output[outputCount++] = &input[i + 1];
+            }
+        }
+    }
+
+    void interpret(const char* input) const {
+        char* argv[2]{};
+        char inputCopy[BUFFER_SIZE];
+        strncpy(inputCopy, input, BUFFER_SIZE);
+        inputCopy[BUFFER_SIZE - 1] = '\0';
+        split(inputCopy, 2, argv);
+
+        for (uint8_t i = 0; i < count; ++i) {
+            if (strcmp(argv[0], names[i]) == 0) {
+                char* commandArgs[3]{};
+                if (argv[1]) split(argv[1], 3, commandArgs);
+                for (auto arg : commandArgs) if (arg) bench::keep(strtol(arg, nullptr, 10));
+                return;
+            }
+        }
+    }
+};
+
+struct FeederCommands {
+    typedef Command<Context> Entry;
+
+    static constexpr Entry table[] = {
+            {"sti", 0x01, 1, {Entry::U32}, noop},
+            {"scj", 0x02, 3, {Entry::U8, Entry::U8, Entry::U8}, noop},
+            {"usj", 0x03, 1, {Entry::U8}, noop},
+            {"gj", 0x04, 0, {}, noop},
+    };
+};
+
+const char* const feederNames[] = {"sti", "scj", "usj", "gj"};
+
+#define COMMAND(name, opcode) {name, opcode, 1, {Entry::U16}, noop}
+
+struct LargeCommands {
+    typedef Command<Context> Entry;
+
+    static constexpr Entry table[] = {
+            COMMAND("sti", 1), COMMAND("scj", 2), COMMAND("usj", 3), COMMAND("gj", 4),
+            COMMAND("gt", 5), COMMAND("led", 6), COMMAND("opn", 7), COMMAND("cls", 8),
+            COMMAND("srv", 9), COMMAND("dbg", 10), COMMAND("lvl", 11), COMMAND("rst", 12),
+            COMMAND("ver", 13), COMMAND("mem", 14), COMMAND("prf", 15), COMMAND("sav", 16),
+            COMMAND("ld", 17), COMMAND("clr", 18), COMMAND("bat", 19), COMMAND("tmp", 20),
+            COMMAND("wgt", 21), COMMAND("cal", 22), COMMAND("btn", 23), COMMAND("slp", 24),
+            COMMAND("wk", 25), COMMAND("sync", 26), COMMAND("drf", 27), COMMAND("exp", 28),
+            COMMAND("bgn", 29), COMMAND("cmt", 30), COMMAND("abt", 31), COMMAND("id", 32),
+    };
+};
+
+#undef COMMAND
+
+const char* const largeNames[] = {
+        "sti", "scj", "usj", "gj", "gt", "led", "opn", "cls", "srv", "dbg", "lvl", "rst", "ver", "mem", "prf", "sav",
+        "ld", "clr", "bat", "tmp", "wgt", "cal", "btn", "slp", "wk", "sync", "drf", "exp", "bgn", "cmt", "abt", "id",
+};
+
+}
+
+int main() {
+    Context context;
+    const uint64_t iterations = 5000000;
+
+    const CommandInterpreter<Context, FeederCommands> feeder{context};
+    const ChainInterpreter feederChain{feederNames, 4};
+    const char* const feederLines[] = {"sti,27000000", "scj,7,30,0", "usj,3", "gj"};
+
+    printf("feeder commands (4), perfect hash seed %u over %u slots\n",
+           CommandMatcher<FeederCommands>::SLOTS.seed, CommandMatcher<FeederCommands>::SLOT_COUNT);
+    for (const auto line : feederLines) {
+        char name[64];
+        snprintf(name, sizeof(name), "  strcmp chain  %s", line);
+        bench::run(name, iterations, [&] { feederChain.interpret(line); });
+        snprintf(name, sizeof(name), "  command table %s", line);
+        bench::run(name, iterations, [&] { feeder.interpret(line, context); });
+    }
+
+    const CommandInterpreter<Context, LargeCommands> large{context};
+    const ChainInterpreter largeChain{largeNames, 32};
+    const char* const largeLines[] = {"sti,1", "mem,1", "sync,1", "id,1", "nope,1"};
+
+    printf("\n32 commands, perfect hash seed %u over %u slots\n",
+           CommandMatcher<LargeCommands>::SLOTS.seed, CommandMatcher<LargeCommands>::SLOT_COUNT);
+    for (const auto line : largeLines) {
+        char name[64];
+        snprintf(name, sizeof(name), "  strcmp chain  %s", line);
+        bench::run(name, iterations, [&] { largeChain.interpret(line); });
+        snprintf(name, sizeof(name), "  command table %s", line);
+        bench::run(name, iterations, [&] { large.interpret(line, context); });
+    }
+    return 0;
+}
@@ -0,0 +1,94 @@
+// The debug clock line as it was (an Arduino String built and compared on every pass) against the
+// one logged on a change of second, in host cycles and heap allocations per act(), with the
+// firmware logging at debug level; and Format against snprintf for the specs it knows.
+
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+#include "../../src/main.cpp"
+#include "Bench.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+uint64_t allocations = 0;
+
+// The clock section of Program::act() before Format.
+void stringClock() {
+    auto time = Time::now();
+    String res;
+    res.concat(time.hours());
+    res.concat(":");
+    res.concat(time.minutes());
+    res.concat(":");
+    res.concat(time.seconds());
+    static String x;
+    if (x != res) {
+        x = res;
+        LOG_DEBUG("clock {}", res.c_str());
+    }
+}
+
+// A pass every 100 us of virtual time, the log sent to a transmit buffer that is never reallocated.
+void pass() {
+    sim::board.advance(100);
+    if (sim::board.tx.size() > (1 << 19)) sim::board.tx.clear();
+}
+
+template<typename TFn> void measure(const char* name, uint64_t iterations, TFn fn) {
+    const auto allocationsBefore = allocations;
+    bench::run(name, iterations, fn);
+    // the warm-up tenth is counted too
+    printf("%-44s %10.3f allocations/op\n", "", (double)(allocations - allocationsBefore) / (iterations + iterations / 10));
+}
+
+}
+
+void* operator new(size_t size) {
+    allocations++;
+    if (void* memory = malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept { free(memory); }
+void operator delete(void* memory, size_t) noexcept { free(memory); }
+
+int main() {
+    const uint64_t iterations = 2000000;
+    sim::board.tx.reserve(1 << 20);
+    setup();
+
+    printf("act() at debug level, a pass every 100 us\n");
+    measure("  act(), clock as a String", iterations, [] {
+        pass();
+        program->act();
+        stringClock();
+    });
+    measure("  act(), clock on a change of second", iterations, [] {
+        pass();
+        program->act();
+    });
+
+    // std::string keeps strings this short inline; the AVR String reallocates on each of the five
+    // concat() calls, and once more when the line is copied for the comparison
+    printf("  (host String has no heap for short text; on the AVR the String clock is 5-6 reallocs per act())\n");
+
+    printf("\nFormat against snprintf\n");
+    char buffer[32];
+    uint32_t value = 0;
+    bench::run("  snprintf %lu", iterations, [&] { bench::keep(snprintf(buffer, sizeof(buffer), "%lu", (unsigned long)++value)); });
+    bench::run("  FORMAT   {}", iterations, [&] { bench::keep(FORMAT(buffer, "{}", ++value)); });
+    bench::run("  snprintf %02u:%02u:%02u", iterations, [&] {
+        const auto seconds = ++value % 86400;
+        bench::keep(snprintf(buffer, sizeof(buffer), "%02u:%02u:%02u", seconds / 3600, seconds / 60 % 60, seconds % 60));
+    });
+    bench::run("  FORMAT   {t}", iterations, [&] { bench::keep(FORMAT(buffer, "{t}", ++value % 86400 * 1000)); });
+    bench::run("  snprintf %04x", iterations, [&] { bench::keep(snprintf(buffer, sizeof(buffer), "%04x", ++value & 0xFFFF)); });
+    bench::run("  FORMAT   {04x}", iterations, [&] { bench::keep(FORMAT(buffer, "{04x}", ++value & 0xFFFF)); });
+    bench::run("  snprintf %d.%02d", iterations, [&] {
+        const int32_t hundredths = ++value % 100000;
+        bench::keep(snprintf(buffer, sizeof(buffer), "%d.%02d", (int)(hundredths / 100), (int)(hundredths % 100)));
+    });
+    bench::run("  FORMAT   {.2}", iterations, [&] { bench::keep(FORMAT(buffer, "{.2}", (int32_t)(++value % 100000))); });
+    return 0;
+}
@@ -0,0 +1,253 @@
+// StreamListener's ingest against the one it replaced (a byte per read(), the terminators rescanned
+// for each, one line handed over per render): megabytes of mixed input (text commands, "\r\n" and
+// bare "\n" endings, binary frames, lines and frames too long for the buffer) arriving in 64-byte
+// USB packets, a packet per pass. Reports passes, host cycles per pass and commands per second.
+
+#define LOG_LEVEL LOG_LEVEL_NONE
+#include "../../src/main.cpp"
+#include "Bench.h"
+
+#include <chrono>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+template<uint8_t bufferSize>
+struct OldStreamListenerState {
+    InlineVector<char, bufferSize> buffer{};
+    bool shouldSendData = false;
+    bool isFrame = false;
+    bool isFrameOverflowed = false;
+};
+
+// StreamListener as it was.
+template <typename TContext, uint8_t bufferSize = 20>
+struct OldStreamListener: Component<OldStreamListener<TContext, bufferSize>, StreamListenerProps<bufferSize>, OldStreamListenerState<bufferSize>> {
+    typedef typename OldStreamListener::Component::Changes Changes;
+    enum: Changes { STREAM_INPUT = 0b01, DATA_READY = 0b10 };
+
+    OldStreamListener(
+            TContext& context,
+            Stream& stream,
+            void(*onInput)(const char*, TContext&),
+            const char* terminatingCharacters = "\r\n",
+            void(*onFrame)(uint8_t*, uint8_t, TContext&) = nullptr
+        ):
+        _context{context},
+        _stream{stream},
+        _terminatingCharacters{terminatingCharacters},
+        _onInput{onInput},
+        _onFrame{onFrame}
+        {}
+
+    void updateProps() {
+        if (_stream.available() > 0) this->touch(STREAM_INPUT);
+    }
+
+    Wake nextWake() const {
+        return Wake{this->isDirty() || _stream.available() > 0 ? 0 : Wake::NEVER, WAKE_SERIAL};
+    }
+
+    // One line or frame per render: a complete one is handed over on the next pass, before reading on.
+    void componentDidUpdate(Changes changes) {
+        auto& state = this->state;
+
+        if ((changes & DATA_READY) && state.shouldSendData) {
+            state.shouldSendData = false;
+            if (state.isFrame) onFrame((uint8_t*)(state.buffer.data()), state.buffer.size());
+            else onInput(state.buffer.data());
+            state.buffer.clear();
+            state.isFrame = false;
+        }
+
+        if (!(changes & STREAM_INPUT)) return;
+
+        bool hasBeenTerminated = false;
+        bool hasFrameEnded = false;
+        bool hasOverflowed = false;
+
+        while (_stream.available() > 0) {
+            const char currentChar = _stream.read();
+            inputTrace.serial(millis(), currentChar);
+
+            if (_onFrame && currentChar == FRAME_DELIMITER) {
+                if (state.isFrame && !state.buffer.isEmpty()) {
+                    if (!state.isFrameOverflowed) {
+                        hasFrameEnded = true;
+                        break;
+                    }
+                    LOG_WARN("frame dropped");
+                    state.isFrame = false;
+                } else state.isFrame = true;
+
+                state.buffer.clear();
+                state.isFrameOverflowed = false;
+                continue;
+            }
+
+            if (state.isFrame) {
+                if (!state.buffer.add(currentChar)) state.isFrameOverflowed = true;
+                continue;
+            }
+
+            auto iter = _terminatingCharacters;
+            while (*iter) if (currentChar == *(iter++)) hasBeenTerminated = true;
+            if (hasBeenTerminated) {
+                // empty lines (the second half of "\r\n", a wake-up byte) are not input
+                if (state.buffer.isEmpty()) {
+                    hasBeenTerminated = false;
+                    continue;
+                }
+                break;
+            }
+
+            if (!state.buffer.add(currentChar)) {
+                hasOverflowed = true;
+                break;
+            }
+        }
+
+        if (hasOverflowed) {
+            // TODO: empty the buffer maybe? undefined behaviour?
+            state.buffer.back() = '\0';
+        } else if (hasBeenTerminated) {
+            if (!state.buffer.add('\0')) state.buffer.back() = '\0';
+        }
+        if (hasFrameEnded || hasOverflowed || hasBeenTerminated) this->set(state.shouldSendData, true, DATA_READY);
+
+        if (_stream.available() > 0) this->touch(STREAM_INPUT);
+    }
+
+private:
+    static const char FRAME_DELIMITER = BinaryProtocol::FRAME_DELIMITER;
+
+    TContext& _context;
+    Stream& _stream;
+    const char* _terminatingCharacters;
+
+    void (*_onInput)(const char*, TContext&);
+    void onInput(const char* value) { if (_onInput) _onInput(value, _context); }
+
+    void (*_onFrame)(uint8_t*, uint8_t, TContext&);
+    void onFrame(uint8_t* frame, uint8_t length) { if (_onFrame) _onFrame(frame, length, _context); }
+};
+
+
+// Input that has arrived up to `arrived`; the rest comes a packet at a time.
+struct PacketStream: Stream {
+    std::vector<uint8_t> bytes;
+    size_t position = 0;
+    size_t arrived = 0;
+
+    int available() override { return (int)(arrived - position); }
+    int peek() override { return position < arrived ? bytes[position] : -1; }
+    int read() override { return position < arrived ? bytes[position++] : -1; }
+    size_t write(uint8_t) override { return 1; }
+    using Print::write;
+
+    void arrive(size_t count) { arrived = std::min(arrived + count, bytes.size()); }
+    bool isDone() const { return position == bytes.size(); }
+};
+
+struct ByteSink: Print {
+    std::vector<uint8_t>* bytes;
+    size_t write(uint8_t value) override { bytes->push_back(value); return 1; }
+    using Print::write;
+};
+
+struct Context {
+    uint32_t lines = 0;
+    uint32_t frames = 0;
+    uint32_t lineBytes = 0;
+};
+
+void onLine(const char* line, Context& context) {
+    context.lines++;
+    context.lineBytes += strlen(line);
+}
+
+void onFrame(uint8_t* frame, uint8_t length, Context& context) {
+    context.frames++;
+    bench::keep(frame[length - 1]);
+}
+
+void addFrame(std::vector<uint8_t>& bytes, std::vector<uint8_t> body) {
+    const auto crc = BinaryProtocol::crc16(body.data(), body.size());
+    body.push_back(crc);
+    body.push_back(crc >> 8);
+    ByteSink sink;
+    sink.bytes = &bytes;
+    BinaryProtocol::send(sink, body.data(), body.size());
+}
+
+// About `size` bytes of commands in the mix a host sends; counts what should be handed over.
+std::vector<uint8_t> mixedInput(size_t size, uint32_t& lines, uint32_t& frames) {
+    const char* const texts[] = {"sti,27000000", "scj,7,30,0", "usj,258", "gj", "sjp,257,170,1200,2", "sjr,256,31,60,1320"};
+    std::vector<uint8_t> bytes;
+    lines = frames = 0;
+    for (uint32_t i = 0; bytes.size() < size; ++i) {
+        const auto text = texts[i % 6];
+        bytes.insert(bytes.end(), text, text + strlen(text));
+        if (i % 3) bytes.push_back('\n');
+        else {
+            bytes.push_back('\r');
+            bytes.push_back('\n');
+        }
+        lines++;
+        if (i % 4 == 0) {
+            addFrame(bytes, {BinaryProtocol::SCHEDULE_JOB, (uint8_t)i, 7, 30, 0});
+            frames++;
+        }
+        if (i % 64 == 0) {
+            const std::string tooLong(40, 'x');
+            bytes.insert(bytes.end(), tooLong.begin(), tooLong.end());
+            bytes.push_back('\n');
+            addFrame(bytes, std::vector<uint8_t>(tooLong.begin(), tooLong.end()));
+        }
+    }
+    return bytes;
+}
+
+template<typename TListener>
+void measure(const char* name, const std::vector<uint8_t>& input, uint32_t lines, uint32_t frames) {
+    PacketStream stream;
+    stream.bytes = input;
+    Context context;
+    TListener listener{context, stream, onLine, "\r\n", onFrame};
+
+    uint64_t passes = 0;
+    const auto wallStart = std::chrono::steady_clock::now();
+    const auto cyclesStart = bench::cycles();
+    while (!stream.isDone() || listener.nextWake().inMs == 0) {
+        stream.arrive(64);
+        listener.react();
+        passes++;
+    }
+    const auto cyclesTaken = bench::cycles() - cyclesStart;
+    const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+    const auto commands = context.lines + context.frames;
+    printf("%s\n", name);
+    printf("  %u of %u lines, %u of %u frames handed over, %u line bytes\n", context.lines, lines, context.frames, frames,
+           context.lineBytes);
+    printf("  %llu passes, %.1f cycles per pass, %.2f passes per command\n", (unsigned long long)passes,
+           (double)cyclesTaken / passes, (double)passes / commands);
+    printf("  %.2f M commands/s, %.1f MB/s on the host\n", commands / seconds / 1e6, input.size() / seconds / 1e6);
+    if constexpr (std::is_same<TListener, StreamListener<Context>>::value) {
+        printf("  dropped too long: %u lines, %u frames\n", listener.linesTruncated, listener.framesOverflowed);
+    }
+}
+
+}
+
+int main() {
+    uint32_t lines, frames;
+    const auto input = mixedInput(8 << 20, lines, frames);
+    printf("%zu bytes: %u lines, %u frames, lines and frames of 40 bytes among them\n\n", input.size(), lines, frames);
+
+    measure<OldStreamListener<Context>>("byte at a time, a line per render", input, lines, frames);
+    measure<StreamListener<Context>>("bulk reads into a ring, terminator lookup", input, lines, frames);
+    return 0;
+}
@@ -0,0 +1,114 @@
+// Text commands against binary frames: bytes on the wire and host cycles to parse and dispatch
+// each command (listeners are no-ops, logging is off, so only the interpreter is measured).
+
+#define LOG_LEVEL LOG_LEVEL_NONE
+#include "../../src/main.cpp"
+#include "Bench.h"
+
+#include <vector>
+
+namespace {
+
+struct ByteSink: Print {
+    std::vector<uint8_t> bytes;
+    size_t write(uint8_t value) override { bytes.push_back(value); return 1; }
+    using Print::write;
+};
+
+struct CountingSink: Print {
+    size_t count = 0;
+    size_t write(uint8_t value) override { count++; return 1; }
+    using Print::write;
+};
+
+struct Context {};
+
+struct Commands {
+    typedef Command<Context> Entry;
+
+    static constexpr Entry table[] = {
+            {"sti", BinaryProtocol::SET_TIME, 1, {Entry::U32}, [](const uint32_t* args, CommandResponse*, Context&) -> uint8_t {
+                bench::keep(args[0]);
+                return BinaryProtocol::OK;
+            }},
+            {"scj", BinaryProtocol::SCHEDULE_JOB, 3, {Entry::U8, Entry::U8, Entry::U8}, [](const uint32_t* args, CommandResponse* response, Context&) -> uint8_t {
+                bench::keep(args[0]);
+                if (response) response->u16(0x0103);
+                return BinaryProtocol::OK;
+            }},
+            {"usj", BinaryProtocol::UNSCHEDULE_JOB, 1, {Entry::U16}, [](const uint32_t* args, CommandResponse*, Context&) -> uint8_t {
+                bench::keep(args[0]);
+                return BinaryProtocol::OK;
+            }},
+            {"gj", BinaryProtocol::LIST_JOBS, 0, {}, [](const uint32_t*, CommandResponse* response, Context&) -> uint8_t {
+                if (!response) return BinaryProtocol::OK;
+                response->u8(3);
+                for (uint8_t i = 0; i < 3; ++i) response->u16(0x0100 | i).u32(27000000UL + i * 3600000UL).u8(0);
+                return BinaryProtocol::OK;
+            }},
+    };
+};
+
+// Wire form of a request: delimiters included.
+std::vector<uint8_t> frame(uint8_t opcode, std::vector<uint8_t> payload) {
+    std::vector<uint8_t> body{opcode, 0x2A};
+    body.insert(body.end(), payload.begin(), payload.end());
+    const auto crc = BinaryProtocol::crc16(body.data(), body.size());
+    body.push_back(crc);
+    body.push_back(crc >> 8);
+
+    ByteSink sink;
+    BinaryProtocol::send(sink, body.data(), body.size());
+    return sink.bytes;
+}
+
+std::vector<uint8_t> le32(uint32_t value) {
+    return {(uint8_t)value, (uint8_t)(value >> 8), (uint8_t)(value >> 16), (uint8_t)(value >> 24)};
+}
+
+struct Case {
+    const char* name;
+    const char* text;
+    std::vector<uint8_t> binary;
+};
+
+}
+
+int main() {
+    Context context;
+    const CommandInterpreter<Context, Commands> interpreter{context};
+    const uint64_t iterations = 5000000;
+
+    const Case cases[] = {
+            {"set time", "sti,27000000", frame(BinaryProtocol::SET_TIME, le32(27000000))},
+            {"schedule job", "scj,7,30,0", frame(BinaryProtocol::SCHEDULE_JOB, {7, 30, 0})},
+            {"unschedule job", "usj,259", frame(BinaryProtocol::UNSCHEDULE_JOB, {3, 1})},
+            {"list jobs (3 jobs)", "gj", frame(BinaryProtocol::LIST_JOBS, {})},
+    };
+
+    printf("%-20s %12s %12s %12s\n", "command", "text bytes", "frame bytes", "reply bytes");
+    for (const auto& command : cases) {
+        std::vector<uint8_t> buffer(command.binary.begin() + 1, command.binary.end() - 1);
+        CountingSink reply;
+        interpreter.interpretFrame(buffer.data(), buffer.size(), reply);
+        printf("%-20s %12zu %12zu %12zu\n", command.name, strlen(command.text) + 1, command.binary.size(), reply.count);
+    }
+    printf("\n");
+
+    for (const auto& command : cases) {
+        char name[64];
+        snprintf(name, sizeof(name), "text   %s", command.name);
+        bench::run(name, iterations, [&] { interpreter.interpret(command.text, context); });
+
+        // The listener hands over the frame without its delimiters; it is decoded in place, so restore it each time.
+        const std::vector<uint8_t> received(command.binary.begin() + 1, command.binary.end() - 1);
+        uint8_t buffer[20];
+        CountingSink reply;
+        snprintf(name, sizeof(name), "binary %s", command.name);
+        bench::run(name, iterations, [&] {
+            memcpy(buffer, received.data(), received.size());
+            interpreter.interpretFrame(buffer, received.size(), reply);
+        });
+    }
+    return 0;
+}
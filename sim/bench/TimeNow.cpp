@@ -0,0 +1,72 @@
+// Cost of reading the wall clock: the packed, incrementally advanced Time against the
+// previous four-field Time that re-derived hours/minutes/seconds by division on every call.
+
+#include "../../src/main.cpp"
+#include "Bench.h"
+
+namespace {
+
+struct FieldTime {
+    uint8_t milliseconds = 0;
+    uint8_t seconds = 0;
+    uint8_t minutes = 0;
+    uint8_t hours = 0;
+
+    uint32_t toMs() const {
+        return (hours * 3600000) + (minutes * 60000) + (seconds * 1000) + milliseconds;
+    }
+
+    static FieldTime now() {
+        auto currentMillis = millis();
+        timeElapsed += getMillisDiff(currentMillis, prevMillis);
+        prevMillis = currentMillis;
+        return FieldTime::fromMs(FieldTime::started.toMs() + timeElapsed);
+    }
+
+    static FieldTime fromMs(unsigned long long duration) {
+        FieldTime time = {};
+        time.milliseconds = (duration % 1000) / 100;
+        time.seconds = (duration / 1000) % 60;
+        time.minutes = (duration / 60000) % 60;
+        time.hours = (duration / 3600000) % 24;
+        return time;
+    }
+
+    static FieldTime started;
+    static uint32_t prevMillis;
+    static uint32_t timeElapsed;
+};
+
+FieldTime FieldTime::started;
+uint32_t FieldTime::prevMillis = 0;
+uint32_t FieldTime::timeElapsed = 0;
+
+}
+
+int main() {
+    const uint64_t iterations = 20000000;
+
+    sim::board.reset();
+    const auto before = bench::run("Time::now (fields, fromMs divisions)", iterations, [] {
+        sim::board.advance(1000);
+        bench::keep(FieldTime::now());
+    });
+
+    sim::board.reset();
+    const auto after = bench::run("Time::now (packed ms-of-day)", iterations, [] {
+        sim::board.advance(1000);
+        bench::keep(Time::now());
+    });
+
+    sim::board.reset();
+    bench::run("Time::now + hours/minutes/seconds split", iterations, [] {
+        sim::board.advance(1000);
+        const auto time = Time::now();
+        bench::keep(time.hours());
+        bench::keep(time.minutes());
+        bench::keep(time.seconds());
+    });
+
+    printf("speedup: %.2fx\n", before.cyclesPerOp / after.cyclesPerOp);
+    return 0;
+}
@@ -0,0 +1,220 @@
+// Replacing every user job with another schedule of as many: one `usj` per old job and one `scj` per
+// new one, as a host did it, against a ScheduleUpload transaction (`sbb`, an `sbj` per job, `sbc`).
+// Bytes on the wire, every reply counted, and round trips for 10 and 100 jobs, as text lines and as
+// frames (the transaction's single one with the host pipelining its frames); host cycles
+// per reprogramming and the EEPROM records it changes, on a scheduler and pool sized for the jobs
+// (the feeder holds 10). Last, the feeder itself takes an upload in frames and its checksum is
+// compared with the one the host computes.
+
+#define LOG_LEVEL LOG_LEVEL_NONE
+#include "../../src/main.cpp"
+#include "Bench.h"
+
+#include <vector>
+
+namespace {
+
+struct ByteSink: Print {
+    std::vector<uint8_t> bytes;
+    size_t write(uint8_t value) override { bytes.push_back(value); return 1; }
+    using Print::write;
+};
+
+// A scheduler, pool and profiles like Program's, CAPACITY jobs of them; the store remembers what
+// it was last given per slot and counts the records a ScheduleStore would write.
+template<uint8_t CAPACITY> struct Context {
+    static constexpr DispenseProfile DEFAULT_PROFILE = Program::DEFAULT_PROFILE;
+    static void feed(Context&, const DayJob<Context>&) {}
+
+    struct Store {
+        Context& context;
+        uint16_t handles[CAPACITY]{};
+        uint32_t values[CAPACITY]{};
+        uint32_t writes = 0;
+
+        void saveJob(uint16_t handle) {
+            const uint8_t slot = handle & 0xFF;
+            const auto current = context.userJobs.handleAt(slot);
+            const auto job = context.userJobs.get(current);
+            const auto value = job ? job->time.toMs() : 0xFFFFFFFF;
+            if (handles[slot] == current && values[slot] == value) return;
+            handles[slot] = current;
+            values[slot] = value;
+            writes++;
+        }
+    };
+
+    DayJobsScheduler<Context, CAPACITY> jobsScheduler{*this};
+    Pool<DayJob<Context>, CAPACITY> userJobs;
+    DispenseProfile jobProfiles[CAPACITY]{};
+    Store store{*this};
+    ScheduleUpload<Context, CAPACITY> upload;
+
+    // `usj` and `scj` as the command table has them.
+    bool unschedule(uint16_t handle) {
+        const auto job = userJobs.get(handle);
+        if (!job) return false;
+        jobsScheduler.unschedule(job);
+        userJobs.destroy(handle);
+        store.saveJob(handle);
+        return true;
+    }
+
+    uint16_t schedule(uint32_t ms) {
+        const auto handle = userJobs.create(Time(ms), feed);
+        if (!handle) return 0;
+        if (!jobsScheduler.schedule(userJobs.get(handle))) {
+            userJobs.destroy(handle);
+            return 0;
+        }
+        jobProfiles[handle & 0xFF] = DEFAULT_PROFILE;
+        store.saveJob(handle);
+        return handle;
+    }
+};
+
+// COUNT jobs spread over the day, `offset` ms later than the other schedule.
+template<uint8_t COUNT> std::vector<uint32_t> schedule(uint32_t offset) {
+    std::vector<uint32_t> ms;
+    for (uint32_t i = 0; i < COUNT; ++i) ms.push_back(i * (Time::DAY_MS / COUNT) + offset);
+    return ms;
+}
+
+void addFrame(ByteSink& sink, uint8_t opcode, std::vector<uint32_t> args, uint8_t argSize) {
+    std::vector<uint8_t> body{opcode, 0x2A};
+    for (const auto arg : args) for (uint8_t i = 0; i < argSize; ++i) body.push_back(arg >> 8 * i);
+    const auto crc = BinaryProtocol::crc16(body.data(), body.size());
+    body.push_back(crc);
+    body.push_back(crc >> 8);
+    BinaryProtocol::send(sink, body.data(), body.size());
+}
+
+// What goes out, and back, for both flows.
+template<uint8_t COUNT> void wire() {
+    const auto ms = schedule<COUNT>(60000);
+    char line[40];
+
+    size_t text = 0;
+    ByteSink frames, responses;
+    for (uint16_t i = 0; i < COUNT; ++i) {
+        text += snprintf(line, sizeof(line), "usj,%u\n", 0x100 | i);
+        addFrame(frames, BinaryProtocol::UNSCHEDULE_JOB, {(uint32_t)(0x100 | i)}, 2);
+        CommandResponse(BinaryProtocol::UNSCHEDULE_JOB, 0x2A, BinaryProtocol::OK).send(responses);
+    }
+    for (const auto value : ms) {
+        text += snprintf(line, sizeof(line), "scj,%u,%u,%u\n", value / 3600000, value / 60000 % 60, value / 1000 % 60);
+        addFrame(frames, BinaryProtocol::SCHEDULE_JOB, {value / 3600000, value / 60000 % 60, value / 1000 % 60}, 1);
+        CommandResponse(BinaryProtocol::SCHEDULE_JOB, 0x2A, BinaryProtocol::OK).u16(0x200).send(responses);
+    }
+    printf("  per job     %6zu B text, %6zu B in frames, %6zu B of responses, %3u round trips\n", text,
+           frames.bytes.size(), responses.bytes.size(), 2 * COUNT);
+
+    text = strlen("sbb\n") + snprintf(line, sizeof(line), "sbc,%u\n", COUNT);
+    ByteSink batchFrames, batchResponses;
+    addFrame(batchFrames, BinaryProtocol::BEGIN_SCHEDULE, {}, 0);
+    CommandResponse(BinaryProtocol::BEGIN_SCHEDULE, 0x2A, BinaryProtocol::OK).send(batchResponses);
+    for (const auto value : ms) {
+        text += snprintf(line, sizeof(line), "sbj,%u,0,0\n", value);
+        addFrame(batchFrames, BinaryProtocol::STAGE_JOB, {value, 0, 0}, 4);
+        CommandResponse(BinaryProtocol::STAGE_JOB, 0x2A, BinaryProtocol::OK).send(batchResponses);
+    }
+    addFrame(batchFrames, BinaryProtocol::COMMIT_SCHEDULE, {COUNT}, 1);
+    CommandResponse(BinaryProtocol::COMMIT_SCHEDULE, 0x2A, BinaryProtocol::OK).u8(COUNT).u16(0).send(batchResponses);
+    // every frame is answered, but the host need not wait for the answers to `sbb` and the stages
+    // before sending on (a rejected one fails the commit): one round trip when it pipelines them
+    printf("  transaction %6zu B text, %6zu B in frames, %6zu B of responses, %3u round trip, pipelined\n", text,
+           batchFrames.bytes.size(), batchResponses.bytes.size(), 1);
+}
+
+template<uint8_t COUNT> void reprogram(uint64_t iterations) {
+    const std::vector<uint32_t> schedules[] = {schedule<COUNT>(0), schedule<COUNT>(60000)};
+
+    // armed, as a running feeder's scheduler is: every change looks for the next deadline again
+    auto perJob = new Context<COUNT>();
+    for (const auto value : schedules[0]) perJob->schedule(value);
+    perJob->jobsScheduler.react();
+    uint32_t next = 1;
+    const auto perJobWrites = perJob->store.writes;
+    bench::run("  per job", iterations, [&] {
+        for (uint8_t slot = 0; slot < COUNT; ++slot) perJob->unschedule(perJob->userJobs.handleAt(slot));
+        for (const auto value : schedules[next++ & 1]) perJob->schedule(value);
+    });
+
+    auto batch = new Context<COUNT>();
+    for (const auto value : schedules[0]) batch->schedule(value);
+    batch->jobsScheduler.react();
+    next = 1;
+    const auto batchWrites = batch->store.writes;
+    bool isCommitted = true;
+    bench::run("  transaction", iterations, [&] {
+        batch->upload.begin();
+        for (const auto value : schedules[next++ & 1]) batch->upload.stage(value, 0, 0);
+        isCommitted &= batch->upload.commit(*batch, COUNT) == BinaryProtocol::OK;
+    });
+
+    const auto runs = iterations + iterations / 10;
+    printf("  job records written per reprogramming: %.1f per job, %.1f in a transaction%s\n",
+           (double)(perJob->store.writes - perJobWrites) / runs, (double)(batch->store.writes - batchWrites) / runs,
+           isCommitted ? "" : " (a commit failed)");
+    delete perJob;
+    delete batch;
+}
+
+// CRC-16 of the jobs as ScheduleUpload::checksum takes them, from what the host sent.
+uint16_t hostChecksum(std::vector<uint32_t> ms) {
+    uint16_t crc = 0xFFFF;
+    for (const auto value : ms) {
+        const uint32_t values[] = {value, Recurrence{}.pack(), Program::DEFAULT_PROFILE.pack()};
+        for (const auto field : values) {
+            const uint8_t bytes[] = {(uint8_t)field, (uint8_t)(field >> 8), (uint8_t)(field >> 16), (uint8_t)(field >> 24)};
+            crc = BinaryProtocol::crc16(bytes, sizeof(bytes), crc);
+        }
+    }
+    return crc;
+}
+
+// The feeder's own commands, through the interpreter: its reply to the commit.
+void feederUpload() {
+    setup();
+    const auto ms = schedule<10>(1000);
+
+    ByteSink request;
+    addFrame(request, BinaryProtocol::BEGIN_SCHEDULE, {}, 0);
+    for (const auto value : ms) addFrame(request, BinaryProtocol::STAGE_JOB, {value, 0, 0}, 4);
+    addFrame(request, BinaryProtocol::COMMIT_SCHEDULE, {10}, 1);
+
+    ByteSink reply;
+    // between delimiters, as StreamListener hands frames over
+    auto& bytes = request.bytes;
+    for (size_t start = 0; start < bytes.size(); ++start) {
+        size_t end = start + 1;
+        while (bytes[end]) ++end;
+        reply.bytes.clear();
+        program->commandInterpreter.interpretFrame(&bytes[start + 1], end - start - 1, reply);
+        start = end;
+    }
+
+    uint8_t decoded[16];
+    memcpy(decoded, &reply.bytes[1], reply.bytes.size() - 2);
+    BinaryProtocol::decode(decoded, reply.bytes.size() - 2);
+    const uint16_t checksum = decoded[4] | decoded[5] << 8;
+    printf("\nfeeder: status %u, %u jobs, checksum %04x; host computes %04x\n", decoded[2], decoded[3], checksum,
+           hostChecksum(ms));
+}
+
+}
+
+int main() {
+    printf("wire, 10 jobs replaced\n");
+    wire<10>();
+    printf("wire, 100 jobs replaced\n");
+    wire<100>();
+
+    printf("\nreprogramming 10 jobs\n");
+    reprogram<10>(200000);
+    printf("reprogramming 100 jobs\n");
+    reprogram<100>(20000);
+
+    feederUpload();
+    return 0;
+}
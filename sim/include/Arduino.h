@@ -0,0 +1,149 @@
+#pragma once
+
+// Host stand-in for the subset of the Arduino core used by the firmware.
+// Time, pins and the serial port are driven by the simulator (see Board.h).
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+#define NOT_AN_INTERRUPT (-1)
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+// Every simulated pin has its own external interrupt, numbered like the pin.
+#define digitalPinToInterrupt(pin) ((int8_t)(pin))
+void attachInterrupt(uint8_t interrupt, void (*handler)(), int mode);
+void detachInterrupt(uint8_t interrupt);
+
+// Program memory is ordinary memory on the host.
+#define PROGMEM
+#define PGM_P const char*
+#define pgm_read_byte(address) (*(const uint8_t*)(address))
+#define pgm_read_word(address) (*(const uint16_t*)(address))
+#define pgm_read_dword(address) (*(const uint32_t*)(address))
+#define pgm_read_ptr(address) (*(void* const*)(address))
+#define memcpy_P memcpy
+#define strncmp_P strncmp
+#define strlen_P strlen
+
+inline void interrupts() {}
+inline void noInterrupts() {}
+
+class String {
+public:
+    String() = default;
+    String(const char* value): _value{value ? value : ""} {} // NOLINT(google-explicit-constructor)
+
+    bool concat(const char* value) { _value.append(value ? value : ""); return true; }
+    bool concat(char value) { _value.push_back(value); return true; }
+    bool concat(unsigned char value) { return concat((unsigned long)value); }
+    bool concat(int value) { return concat((long)value); }
+    bool concat(unsigned int value) { return concat((unsigned long)value); }
+    bool concat(long value) { _value.append(std::to_string(value)); return true; }
+    bool concat(unsigned long value) { _value.append(std::to_string(value)); return true; }
+    bool concat(const String& value) { _value.append(value._value); return true; }
+
+    const char* c_str() const { return _value.c_str(); }
+    unsigned int length() const { return _value.length(); }
+
+    bool operator==(const String& other) const { return _value == other._value; }
+    bool operator!=(const String& other) const { return _value != other._value; }
+
+private:
+    std::string _value;
+};
+
+class Print {
+public:
+    virtual ~Print() = default;
+
+    virtual size_t write(uint8_t value) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* str) { return str ? write((const uint8_t*)str, strlen(str)) : 0; }
+    virtual int availableForWrite() { return 0; }
+    virtual void flush() {}
+
+    size_t print(const char* value);
+    size_t print(const String& value);
+    size_t print(char value);
+    size_t print(unsigned char value, int base = DEC);
+    size_t print(int value, int base = DEC);
+    size_t print(unsigned int value, int base = DEC);
+    size_t print(long value, int base = DEC);
+    size_t print(unsigned long value, int base = DEC);
+    size_t print(double value, int digits = 2);
+
+    size_t println();
+    template<typename T> size_t println(const T value) { return print(value) + println(); }
+    template<typename T> size_t println(const T value, int format) { return print(value, format) + println(); }
+
+private:
+    size_t printNumber(unsigned long value, uint8_t base);
+};
+
+class Stream: public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    size_t readBytes(char* buffer, size_t length);
+};
+
+// The ATmega32U4's USB device; Serial is its CDC port.
+#define USBCON
+
+class USBDevice_ {
+public:
+    bool configured();
+};
+
+extern USBDevice_ USBDevice;
+
+class Serial_: public Stream {
+public:
+    void begin(unsigned long baud);
+    void end() {}
+    explicit operator bool() const { return true; }
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    int availableForWrite() override;
+    // the host has the port open
+    bool dtr();
+
+    size_t write(uint8_t value) override;
+    using Print::write;
+};
+
+extern Serial_ Serial;
@@ -0,0 +1,98 @@
+#pragma once
+
+// Simulated Pro Micro: a virtual clock, pin levels, a serial port and servo outputs
+// that the host stand-ins for Arduino.h and Servo.h read from and write to.
+
+#include <cstdint>
+#include <deque>
+#include <string>
+
+struct Wake;
+
+namespace sim {
+
+struct Board {
+    static const uint8_t PIN_COUNT = 32;
+    static const uint8_t SERIAL_TX_BUFFER_SIZE = 64;
+
+    uint64_t micros = 0;
+    // How far the MCU's own clock runs from `micros`, in ppm, positive when fast: millis() and
+    // micros() count its time. Everything else, sleeps and inputs included, stays on `micros`.
+    double clockDriftPpm = 0;
+
+    uint8_t pinModes[PIN_COUNT]{};
+    uint8_t pinLevels[PIN_COUNT]{};
+    // attachInterrupt handlers, run from setLevel as soon as a matching edge happens
+    void (*pinInterrupts[PIN_COUNT])(){};
+    int pinInterruptModes[PIN_COUNT]{};
+
+    std::deque<uint8_t> rx;
+    std::string tx;
+    bool echo = false;
+    // When set, writes behave like a UART at `baud`: once the transmit buffer is full
+    // the caller blocks (the virtual clock advances) until a byte has been shifted out.
+    bool pacedSerial = false;
+    unsigned long baud = 0;
+    // When cleared, no host has the USB port open: it is not configured, nothing written goes out
+    // and the transmit buffer reads as full, as the CDC endpoint's does.
+    bool hostAttached = true;
+    uint64_t txDrainedAt = 0;
+    uint64_t txStallMicros = 0;
+
+    int16_t servoAngles[PIN_COUNT]{};
+    uint32_t servoWrites = 0;
+    // While any servo is attached the Servo library keeps Timer1 and its interrupt running.
+    uint8_t servosAttached = 0;
+    uint64_t servoAttachedSince = 0;
+    uint64_t servoAttachedMicros = 0;
+
+    // When set, Sleep::until moves the virtual clock like the MCU would sleep: in idle up to the
+    // next ms tick, in power-down for a watchdog period plus the oscillator start-up. The driver
+    // tells when the next input arrives so that a watched one can end the sleep early.
+    bool sleepEnabled = false;
+    uint64_t nextPinChangeAt = UINT64_MAX;
+    uint64_t nextRxAt = UINT64_MAX;
+    bool isRxWakeByteLost = false;
+    // When set as well, sleeps end exactly at the deadline or the next input, as if waking up
+    // cost nothing: what a replay needs to run inputs through the firmware at their recorded ms.
+    bool exactSleep = false;
+    uint32_t wakeUps = 0;
+    uint64_t idleMicros = 0;
+    uint64_t powerDownMicros = 0;
+
+    // When set, what the firmware drives is appended as lines "<ms> <output>": "servo <pin>
+    // <angle>" per write, "pin <pin> <level>" per change and "tx <hex>" for the serial bytes of
+    // a ms. Golden runs of a replay are compared on it.
+    std::string* outputLog = nullptr;
+
+    void reset();
+
+    uint64_t localMicros() const { return clockDriftPpm ? (uint64_t)(micros * (1 + clockDriftPpm / 1e6)) : micros; }
+
+    void advance(uint64_t us) { micros += us; }
+    void advanceMs(uint64_t ms) { micros += ms * 1000; }
+
+    void setLevel(uint8_t pin, bool high);
+    bool level(uint8_t pin) const { return pinLevels[pin % PIN_COUNT]; }
+
+    void receive(const char* data);
+    void transmit(uint8_t value);
+    int txFree() const;
+
+    void sleep(const Wake& wake);
+
+    void logOutput(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+    void setServoAttached(bool isAttached);
+    // Time with a servo attached so far, the current stretch included.
+    uint64_t servoAttachedTime() const;
+
+private:
+    uint64_t _txLineMs = UINT64_MAX;
+
+    uint64_t byteMicros() const { return baud ? 10000000ULL / baud : 0; }
+};
+
+extern Board board;
+
+}
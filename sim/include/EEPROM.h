@@ -0,0 +1,48 @@
+#pragma once
+
+// Host stand-in for the Arduino EEPROM library: the ATmega32U4's 1 KB EEPROM, erased (0xFF) in
+// memory, or mapped from a file with sim::eeprom.map() so it keeps its content between runs.
+//
+// Every byte that really changes counts as an erase/write cycle of its cell and, as on the chip,
+// keeps the CPU waiting 3.4 ms, which moves the virtual clock on.
+
+#include <Arduino.h>
+
+namespace sim {
+
+struct Eeprom {
+    static const uint16_t SIZE = 1024;
+    static const uint16_t WRITE_US = 3400;
+
+    uint8_t* cells = memory;
+    uint32_t cycles[SIZE]{};
+    uint64_t reads = 0;
+    uint64_t writes = 0;
+    // writes left before the power goes (further updates are lost), -1 for never
+    int64_t writesUntilPowerLoss = -1;
+
+    Eeprom();
+    ~Eeprom();
+
+    // Backs the EEPROM by `path`, created erased if missing; false if it cannot be mapped.
+    bool map(const char* path);
+    void erase();
+    void resetCounters();
+
+private:
+    uint8_t memory[SIZE];
+    int _file = -1;
+};
+
+extern Eeprom eeprom;
+
+}
+
+struct EEPROMClass {
+    uint8_t read(int address);
+    void write(int address, uint8_t value);
+    void update(int address, uint8_t value);
+    uint16_t length() const { return sim::Eeprom::SIZE; }
+};
+
+extern EEPROMClass EEPROM;
@@ -0,0 +1,39 @@
+#pragma once
+
+// Host stand-in for arduino-libraries/Servo, recording the commanded angle per pin and how long
+// a servo is attached.
+
+#include <Arduino.h>
+#include "Board.h"
+
+class Servo {
+public:
+    uint8_t attach(int pin) {
+        _pin = pin;
+        if (!_attached) sim::board.setServoAttached(true);
+        _attached = true;
+        return 0;
+    }
+
+    void detach() {
+        if (_attached) sim::board.setServoAttached(false);
+        _attached = false;
+    }
+    bool attached() const { return _attached; }
+
+    void write(int value) {
+        if (value < 0) value = 0;
+        if (value > 180) value = 180;
+        _angle = value;
+        if (_pin >= 0) sim::board.servoAngles[_pin % sim::Board::PIN_COUNT] = (int16_t)value;
+        sim::board.servoWrites++;
+        sim::board.logOutput("servo %d %d", _pin, value);
+    }
+
+    int read() const { return _angle; }
+
+private:
+    int _pin = -1;
+    int _angle = 0;
+    bool _attached = false;
+};
@@ -0,0 +1,233 @@
+// Runs the firmware against the simulated board on a virtual clock.
+//
+// A scripted day of feeding (serial commands, button presses and the scheduled jobs they create)
+// is replayed as fast as the host allows; the report lists every servo opening and how many
+// Program::act() iterations per second the firmware logic sustained.
+//
+// With --sleep the firmware's idle() really sleeps on the virtual clock (see Board::sleep), and the
+// report adds wake-ups per day and the worst delay from an input arriving to the loop pass that
+// handles it.
+//
+// --eeprom FILE keeps the EEPROM in FILE, so a second run boots with the schedule the first one
+// saved (and its `scj` commands are rejected as duplicates).
+//
+// --capture FILE saves the serial output; of PetFeederSimTrace, the firmware built with
+// INPUT_TRACE, it is a trace for tools/Replay.
+//
+// --no-host leaves the USB port unplugged: no commands come in and nothing goes out, so only the
+// button is pressed (with --eeprom, the schedule of an earlier run is kept). With --sleep, the
+// power-down time shows that the log waiting for a host does not keep the feeder awake.
+
+#include "../src/main.cpp"
+#include "LogDecoder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+namespace {
+
+const uint8_t BUTTON_PIN = 2;
+const uint8_t SERVO_PIN = 9;
+const uint8_t LED_PIN = 13;
+const uint64_t DAY_MS = 24ULL * 60 * 60 * 1000;
+
+struct Event {
+    enum Kind { SERIAL, PIN };
+
+    uint64_t atMs;
+    Kind kind;
+    const char* description;
+    std::function<void()> apply;
+};
+
+uint64_t clockMs(uint8_t hours, uint8_t minutes, uint8_t seconds = 0) {
+    return ((hours * 60ULL + minutes) * 60 + seconds) * 1000;
+}
+
+// Lines start with a terminator, as a host does to wake a sleeping feeder.
+Event command(uint64_t atMs, const char* line) {
+    return {atMs, Event::SERIAL, line, [line] { sim::board.receive("\n"); sim::board.receive(line); sim::board.receive("\n"); }};
+}
+
+Event button(uint64_t atMs, bool high) {
+    return {atMs, Event::PIN, high ? "button down" : "button up", [high] { sim::board.setLevel(BUTTON_PIN, high); }};
+}
+
+uint64_t nextOf(const std::vector<Event>& events, size_t from, Event::Kind kind) {
+    for (auto i = from; i < events.size(); ++i) {
+        if (events[i].kind == kind) return events[i].atMs * 1000;
+    }
+    return UINT64_MAX;
+}
+
+// The clock is set to 06:00 right after boot, so event times are offsets from 06:00.
+std::vector<Event> dayOfFeeding(uint64_t dayStartMs) {
+    const auto at = [dayStartMs](uint8_t hours, uint8_t minutes, uint8_t seconds = 0) {
+        return dayStartMs + clockMs(hours, minutes, seconds) - clockMs(6, 0);
+    };
+    return {
+            command(dayStartMs + 100, "sti,21600000"),
+            command(dayStartMs + 200, "scj,7,30,0"),
+            command(dayStartMs + 300, "scj,12,0,0"),
+            command(dayStartMs + 400, "scj,18,30,0"),
+            command(dayStartMs + 500, "gj"),
+            button(at(8, 0), true),
+            button(at(8, 0) + 120, false),
+            button(at(9, 0), true),
+            button(at(9, 0) + 1500, false),
+            // the 18:30 job: third pool slot, first generation
+            command(at(13, 0), "usj,258"),
+            command(at(13, 0) + 100, "gj"),
+    };
+}
+
+struct Options {
+    uint32_t tickUs = 1000;
+    bool echo = false;
+    bool pacedSerial = false;
+    bool sleep = false;
+    bool noHost = false;
+    const char* eeprom = nullptr;
+    const char* capture = nullptr;
+};
+
+Options parse(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--tick-us") && i + 1 < argc) options.tickUs = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--echo")) options.echo = true;
+        else if (!strcmp(argv[i], "--paced-serial")) options.pacedSerial = true;
+        else if (!strcmp(argv[i], "--sleep")) options.sleep = true;
+        else if (!strcmp(argv[i], "--no-host")) options.noHost = true;
+        else if (!strcmp(argv[i], "--eeprom") && i + 1 < argc) options.eeprom = argv[++i];
+        else if (!strcmp(argv[i], "--capture") && i + 1 < argc) options.capture = argv[++i];
+        else {
+            fprintf(stderr, "usage: %s [--tick-us N] [--echo] [--paced-serial] [--sleep] [--no-host] [--eeprom FILE] [--capture FILE]\n",
+                    argv[0]);
+            exit(2);
+        }
+    }
+    if (!options.tickUs) options.tickUs = 1;
+    return options;
+}
+
+}
+
+int main(int argc, char** argv) {
+    const auto options = parse(argc, argv);
+
+    sim::board.reset();
+    sim::board.pacedSerial = options.pacedSerial;
+    sim::board.sleepEnabled = options.sleep;
+    sim::board.hostAttached = !options.noHost;
+    if (options.eeprom && !sim::eeprom.map(options.eeprom)) {
+        fprintf(stderr, "cannot map %s\n", options.eeprom);
+        return 1;
+    }
+
+    sim::LogDecoder decoder;
+    decoder.index(PETFEEDER_SOURCE_DIR "/src");
+    decoder.index(PETFEEDER_SOURCE_DIR "/lib");
+    size_t decodedBytes = 0;
+
+    setup();
+
+    auto events = dayOfFeeding(millis());
+    if (options.noHost) {
+        events.erase(std::remove_if(events.begin(), events.end(), [](const Event& event) { return event.kind == Event::SERIAL; }),
+                     events.end());
+    }
+    const auto endMs = millis() + DAY_MS - clockMs(6, 0);
+    size_t nextEvent = 0;
+
+    uint64_t iterations = 0;
+    uint32_t servoOpenings = 0;
+    auto servoWasOpen = false;
+    uint64_t worstLatencyUs = 0;
+    const char* worstLatencyEvent = "";
+
+    const auto wallStart = std::chrono::steady_clock::now();
+    while (sim::board.micros / 1000 < endMs) {
+        while (nextEvent < events.size() && events[nextEvent].atMs <= sim::board.micros / 1000) {
+            const auto& event = events[nextEvent++];
+            event.apply();
+            // handled by the pass about to run
+            const auto latencyUs = sim::board.micros - event.atMs * 1000;
+            if (latencyUs >= worstLatencyUs) {
+                worstLatencyUs = latencyUs;
+                worstLatencyEvent = event.description;
+            }
+        }
+        sim::board.nextPinChangeAt = nextOf(events, nextEvent, Event::PIN);
+        sim::board.nextRxAt = nextOf(events, nextEvent, Event::SERIAL);
+
+        const auto passStart = sim::board.micros;
+        loop();
+        ++iterations;
+
+        if (options.echo && decodedBytes < sim::board.tx.size()) {
+            decoder.feed((const uint8_t*)sim::board.tx.data() + decodedBytes, sim::board.tx.size() - decodedBytes,
+                         [](const std::string& line) { printf("%s\n", line.c_str()); });
+            decodedBytes = sim::board.tx.size();
+        }
+
+        const auto servoIsOpen = sim::board.servoAngles[SERVO_PIN] > 0;
+        if (servoIsOpen && !servoWasOpen) {
+            ++servoOpenings;
+            const auto time = Time::now();
+            printf("servo opened at %02u:%02u:%02u.%03u\n", time.hours(), time.minutes(), time.seconds(), time.milliseconds());
+        }
+        servoWasOpen = servoIsOpen;
+
+        // a pass that slept has already moved the clock; one that did not costs a tick
+        if (sim::board.micros == passStart) sim::board.advance(options.tickUs);
+    }
+    const auto wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+    const auto simulatedSeconds = sim::board.micros / 1e6;
+    printf("simulated:        %.0f s (%llu act() calls, %u us per tick)\n",
+           simulatedSeconds, (unsigned long long)iterations, options.tickUs);
+    printf("wall time:        %.3f s (%.0fx real time)\n", wallSeconds, simulatedSeconds / wallSeconds);
+    printf("act() per second: %.0f\n", iterations / wallSeconds);
+    printf("servo openings:   %u (%u servo writes, attached %.3f%% of the time)\n", servoOpenings, sim::board.servoWrites,
+           100.0 * sim::board.servoAttachedTime() / sim::board.micros);
+    printf("red led:          %s\n", sim::board.level(LED_PIN) ? "on" : "off");
+    printf("serial out:       %zu bytes", sim::board.tx.size());
+    if (options.pacedSerial) printf(", %.3f s stalled on a full transmit buffer", sim::board.txStallMicros / 1e6);
+    printf("\n");
+    printf("log records lost: %lu\n", (unsigned long)logger.droppedTotal);
+    if (INPUT_TRACE) printf("trace records lost: %lu\n", (unsigned long)inputTrace.droppedTotal);
+    printf("pin edges lost:   %u\n", PinEdges::overflows());
+    printf("eeprom:           %u records, %llu bytes written\n",
+           program->store.recordsWritten(), (unsigned long long)sim::eeprom.writes);
+    printf("input latency:    %.3f ms worst (%s)\n", worstLatencyUs / 1e3, worstLatencyEvent);
+    if (PROFILER) {
+        static const char* const sections[] = {"act", "button", "servo", "scheduler", "store", "listener", "clock", "output"};
+        printf("profile:          %-10s %10s %12s %8s\n", "section", "calls", "total us", "max us");
+        for (uint8_t section = 0; section < PROFILE_SECTIONS; ++section) {
+            const auto& stats = profiler.stats(section);
+            printf("                  %-10s %10lu %12lu %8u\n", sections[section], (unsigned long)stats.count,
+                   (unsigned long)stats.totalUs, stats.maxUs);
+        }
+    }
+    if (options.sleep) {
+        const auto awakeMicros = sim::board.micros - sim::board.idleMicros - sim::board.powerDownMicros;
+        printf("wake-ups:         %u (%.0f per day)\n", sim::board.wakeUps, sim::board.wakeUps * 86400.0 / simulatedSeconds);
+        printf("time asleep:      %.2f%% power-down, %.2f%% idle, %.2f%% awake\n",
+               100.0 * sim::board.powerDownMicros / sim::board.micros, 100.0 * sim::board.idleMicros / sim::board.micros,
+               100.0 * awakeMicros / sim::board.micros);
+    }
+
+    if (options.capture) {
+        auto file = fopen(options.capture, "wb");
+        if (!file || fwrite(sim::board.tx.data(), 1, sim::board.tx.size(), file) != sim::board.tx.size()) {
+            fprintf(stderr, "cannot write %s\n", options.capture);
+            return 1;
+        }
+        fclose(file);
+    }
+    return 0;
+}
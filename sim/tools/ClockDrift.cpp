@@ -0,0 +1,181 @@
+// A feeder whose crystal runs off by a set number of ppm, synced from a host every so often over
+// a link with a round trip and some jitter either way, through `syn` and `sya` frames.
+//
+//   ClockDrift [--drift-ppm P] [--syncs N] [--interval-min M] [--rtt-ms R] [--jitter-ms J] [--seed S]
+//
+// The feeder starts at midnight with the host at 08:00, so the first exchange steps the clock and
+// the later ones slew it. Per exchange: the round trip, the offset applied and the rate the feeder
+// has come to, and its error against the host just before (feeder less host). At the end, the error
+// left after the last exchange, the worst one once a rate was set and slewed in, and the rate against the drift. A scheduler
+// with a job every 5 minutes runs alongside; every occurrence after the first sync must run once.
+
+#define LOG_LEVEL LOG_LEVEL_NONE
+#include "../../src/main.cpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+const uint32_t HOST_START_MS = 8 * 3600000UL;
+const uint32_t JOB_INTERVAL_MIN = 5;
+const uint32_t JOB_OCCURRENCES = Time::WEEK_MS / (JOB_INTERVAL_MIN * 60000);
+
+struct ByteSink: Print {
+    std::vector<uint8_t> bytes;
+    size_t write(uint8_t value) override { bytes.push_back(value); return 1; }
+    using Print::write;
+};
+
+struct Reply {
+    uint8_t status = 0xFF;
+    std::vector<uint8_t> payload;
+
+    uint32_t u32(uint8_t at) const {
+        return payload[at] | payload[at + 1] << 8 | payload[at + 2] << 16 | (uint32_t)payload[at + 3] << 24;
+    }
+};
+
+// One request frame through the firmware's interpreter, as the listener hands it over.
+Reply request(uint8_t opcode, uint32_t argument) {
+    std::vector<uint8_t> body{opcode, 0x2A};
+    for (uint8_t i = 0; i < 4; ++i) body.push_back(argument >> 8 * i);
+    const auto crc = BinaryProtocol::crc16(body.data(), body.size());
+    body.push_back(crc);
+    body.push_back(crc >> 8);
+
+    ByteSink wire, replyWire;
+    BinaryProtocol::send(wire, body.data(), body.size());
+    std::vector<uint8_t> frame(wire.bytes.begin() + 1, wire.bytes.end() - 1);
+    program->commandInterpreter.interpretFrame(frame.data(), frame.size(), replyWire);
+
+    std::vector<uint8_t> replyFrame(replyWire.bytes.begin() + 1, replyWire.bytes.end() - 1);
+    const auto length = BinaryProtocol::decode(replyFrame.data(), replyFrame.size());
+    Reply reply;
+    if (length < 3 + BinaryProtocol::CRC_SIZE) return reply;
+    reply.status = replyFrame[2];
+    reply.payload.assign(replyFrame.begin() + 3, replyFrame.begin() + length - BinaryProtocol::CRC_SIZE);
+    return reply;
+}
+
+uint32_t hostMs() { return (HOST_START_MS + sim::board.micros / 1000) % Time::DAY_MS; }
+
+// The feeder's clock less the host's, ms, across midnight either way.
+int32_t errorMs() {
+    auto error = (int32_t)((Time::nowMs() + Time::DAY_MS - hostMs()) % Time::DAY_MS);
+    return error > (int32_t)(Time::DAY_MS / 2) ? error - (int32_t)Time::DAY_MS : error;
+}
+
+// A scheduler of its own with one job every JOB_INTERVAL_MIN minutes, all day; each run is noted
+// by its occurrence in the week.
+struct Context {
+    DayJobsScheduler<Context, 1> jobsScheduler{*this};
+    DayJob<Context> job{Time(), run, false, Recurrence(Recurrence::EVERY_DAY, JOB_INTERVAL_MIN, Recurrence::MAX_MINUTE)};
+    bool isWatching = false;
+    uint32_t last = 0;
+    uint32_t runs = 0, skipped = 0, doubled = 0;
+
+    static void run(Context& context, const DayJob<Context>&) {
+        const auto occurrence = Time::nowWeekMs() / (JOB_INTERVAL_MIN * 60000);
+        if (context.isWatching && context.runs) {
+            const auto step = (occurrence + JOB_OCCURRENCES - context.last) % JOB_OCCURRENCES;
+            if (!step) context.doubled++;
+            else context.skipped += step - 1;
+        }
+        if (context.isWatching) context.runs++;
+        context.last = occurrence;
+    }
+};
+
+}
+
+int main(int argc, char** argv) {
+    double driftPpm = 180;
+    uint32_t syncs = 24, intervalMin = 60, rttMs = 60, jitterMs = 20, seed = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--drift-ppm") && i + 1 < argc) driftPpm = strtod(argv[++i], nullptr);
+        else if (!strcmp(argv[i], "--syncs") && i + 1 < argc) syncs = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--interval-min") && i + 1 < argc) intervalMin = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--rtt-ms") && i + 1 < argc) rttMs = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--jitter-ms") && i + 1 < argc) jitterMs = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = strtoul(argv[++i], nullptr, 10);
+        else {
+            fprintf(stderr, "usage: %s [--drift-ppm P] [--syncs N] [--interval-min M] [--rtt-ms R] [--jitter-ms J] [--seed S]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (!syncs || !intervalMin) {
+        fprintf(stderr, "%s: at least one sync, at least a minute apart\n", argv[0]);
+        return 2;
+    }
+
+    sim::board.reset();
+    sim::board.clockDriftPpm = driftPpm;
+    setup();
+    auto context = new Context();
+    context->jobsScheduler.schedule(&context->job);
+
+    std::mt19937 random{seed};
+    // a pass every 100 ms of host time
+    const auto pass = [&](uint64_t us) {
+        for (uint64_t done = 0; done < us; done += 100000) {
+            sim::board.advance(us - done < 100000 ? us - done : 100000);
+            program->act();
+            context->jobsScheduler.react();
+        }
+    };
+    const auto latencyUs = [&] { return (rttMs * 500ULL) + random() % (jitterMs * 1000ULL + 1); };
+
+    printf("drift %.1f ppm (%.2f s a day unsynced), a sync every %u min, round trip %u ms + up to %u ms each way\n\n",
+           driftPpm, driftPpm * 86400 / 1e6, intervalMin, rttMs, jitterMs);
+    printf("%5s %8s %12s %12s %14s\n", "sync", "rtt ms", "offset ms", "rate ppm", "error before");
+
+    int32_t lastErrorBefore = 0, worst = 0;
+    uint32_t rejected = 0;
+    for (uint32_t sync = 1; sync <= syncs; ++sync) {
+        const auto errorBefore = errorMs();
+
+        const auto sentMs = hostMs();
+        pass(latencyUs());
+        const auto answer = request(BinaryProtocol::SYNC_TIME, sentMs);
+        pass(latencyUs());
+        const auto arrivedMs = hostMs();
+        pass(latencyUs());
+        const auto reply = request(BinaryProtocol::SYNC_ADJUST, arrivedMs);
+        if (answer.status != BinaryProtocol::OK || reply.status != BinaryProtocol::OK) {
+            rejected++;
+            printf("%5u rejected\n", sync);
+        } else {
+            const auto offsetMs = (int32_t)reply.u32(2);
+            const auto ratePpm100 = (int32_t)reply.u32(6);
+            printf("%5u %8u %12d %12.2f %14d\n", sync, reply.payload[0] | reply.payload[1] << 8, offsetMs,
+                   ratePpm100 / 100.0, sync == 1 ? 0 : errorBefore);
+        }
+        if (sync > 1) lastErrorBefore = errorBefore;
+        context->isWatching = true;
+
+        // the error each host second until the next exchange
+        const auto seconds = intervalMin * 60;
+        for (uint32_t second = 0; second < seconds; ++second) {
+            pass(1000000);
+            const auto error = errorMs();
+            // the first interval runs on the crystal alone, the second slews in what it drifted
+            if (sync > 2 && std::abs(error) > std::abs(worst)) worst = error;
+        }
+    }
+    const auto residualMs = errorMs();
+
+    const auto rate = ClockSync::ratePpm100() / 100.0;
+    printf("\nafter %u syncs: %d ms off %u min after the last, %d ms before it; %d ms at worst from the third on\n",
+           syncs, residualMs, intervalMin, lastErrorBefore, worst);
+    printf("rate %.2f ppm against %.2f ppm of drift: %.2f ppm (%.3f s a day) left\n", rate,
+           -driftPpm / (1 + driftPpm / 1e6), rate + driftPpm / (1 + driftPpm / 1e6),
+           (rate + driftPpm / (1 + driftPpm / 1e6)) * 86400 / 1e6);
+    printf("exchanges rejected: %u\n", rejected);
+    printf("jobs every %u min: %u runs, %u occurrences skipped, %u run twice\n", JOB_INTERVAL_MIN, context->runs,
+           context->skipped, context->doubled);
+    return context->skipped || context->doubled ? 1 : 0;
+}
@@ -0,0 +1,303 @@
+// Randomized schedule/unschedule soak of the user job pool, driven through the binary command
+// interface of the firmware, with a free-memory and fragmentation report at the end.
+//
+//   JobSoak [--operations N] [--seed S]
+//
+// Unschedule requests pick from every id ever handed out, so most of them are stale; each one must
+// be rejected unless its job is still scheduled. The same operation sequence is replayed against a
+// model of the heap the jobs used to come from (avr-libc's first-fit malloc, AVR object sizes,
+// plus the String churn of the debug clock line) to show what the pool replaced.
+
+#define LOG_LEVEL LOG_LEVEL_NONE
+#include "../../src/main.cpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace {
+
+// heap allocations made by the firmware while `isFirmwareRunning`
+size_t heapAllocations = 0;
+bool isFirmwareRunning = false;
+
+void runFirmware(void (*step)()) {
+    isFirmwareRunning = true;
+    step();
+    isFirmwareRunning = false;
+}
+
+struct ByteSink: Print {
+    std::vector<uint8_t> bytes;
+    size_t write(uint8_t value) override { bytes.push_back(value); return 1; }
+    using Print::write;
+};
+
+// Sends one request frame to the firmware's interpreter; the reply's status and payload.
+struct Reply {
+    uint8_t status = 0xFF;
+    std::vector<uint8_t> payload;
+};
+
+Reply request(uint8_t opcode, std::vector<uint8_t> payload) {
+    std::vector<uint8_t> body{opcode, 0x2A};
+    body.insert(body.end(), payload.begin(), payload.end());
+    const auto crc = BinaryProtocol::crc16(body.data(), body.size());
+    body.push_back(crc);
+    body.push_back(crc >> 8);
+
+    ByteSink wire;
+    BinaryProtocol::send(wire, body.data(), body.size());
+    // the listener hands over the frame between its delimiters
+    std::vector<uint8_t> frame(wire.bytes.begin() + 1, wire.bytes.end() - 1);
+    static ByteSink replyWire;
+    static std::vector<uint8_t>* pending;
+    replyWire.bytes.clear();
+    // COBS adds a byte per 254 and the delimiters two
+    replyWire.bytes.reserve(COMMAND_RESPONSE_SIZE + 4);
+    pending = &frame;
+    runFirmware([] { program->commandInterpreter.interpretFrame(pending->data(), pending->size(), replyWire); });
+
+    std::vector<uint8_t> replyFrame(replyWire.bytes.begin() + 1, replyWire.bytes.end() - 1);
+    const auto length = BinaryProtocol::decode(replyFrame.data(), replyFrame.size());
+    Reply reply;
+    if (length < 3 + BinaryProtocol::CRC_SIZE) return reply;
+    reply.status = replyFrame[2];
+    reply.payload.assign(replyFrame.begin() + 3, replyFrame.begin() + length - BinaryProtocol::CRC_SIZE);
+    return reply;
+}
+
+// avr-libc malloc in miniature: a 2-byte size header per chunk, first fit from the lowest address,
+// neighbours merged on free, the break lowered when the topmost chunk is freed.
+struct AvrHeap {
+    static const size_t HEADER = 2;
+    // chunk start → size, header included
+    std::map<size_t, size_t> freeChunks;
+    std::map<size_t, size_t> usedChunks;
+    size_t brk = 0;
+    size_t highWater = 0;
+
+    size_t alloc(size_t size) {
+        const auto needed = size + HEADER;
+        for (auto chunk = freeChunks.begin(); chunk != freeChunks.end(); ++chunk) {
+            if (chunk->second < needed) continue;
+            const auto at = chunk->first;
+            const auto left = chunk->second - needed;
+            freeChunks.erase(chunk);
+            // a remainder too small for a header and a byte stays with the chunk
+            if (left > HEADER) {
+                freeChunks[at + needed] = left;
+                usedChunks[at] = needed;
+            } else usedChunks[at] = needed + left;
+            return at;
+        }
+        const auto at = brk;
+        brk += needed;
+        if (brk > highWater) highWater = brk;
+        usedChunks[at] = needed;
+        return at;
+    }
+
+    void free(size_t at) {
+        auto size = usedChunks[at];
+        usedChunks.erase(at);
+        const auto next = freeChunks.find(at + size);
+        if (next != freeChunks.end()) {
+            size += next->second;
+            freeChunks.erase(next);
+        }
+        auto previous = freeChunks.lower_bound(at);
+        if (previous != freeChunks.begin() && (--previous)->first + previous->second == at) {
+            at = previous->first;
+            size += previous->second;
+        }
+        if (at + size == brk) {
+            freeChunks.erase(at);
+            brk = at;
+        } else freeChunks[at] = size;
+    }
+
+    // Grows in place into a free neighbour or at the break, moves otherwise (as realloc does).
+    size_t realloc(size_t at, size_t size, bool isUsed) {
+        if (!isUsed) return alloc(size);
+        const auto needed = size + HEADER;
+        auto& current = usedChunks[at];
+        if (current >= needed) return at;
+        if (at + current == brk) {
+            brk = at + needed;
+            if (brk > highWater) highWater = brk;
+            current = needed;
+            return at;
+        }
+        const auto next = freeChunks.find(at + current);
+        if (next != freeChunks.end() && current + next->second >= needed) {
+            const auto total = current + next->second;
+            freeChunks.erase(next);
+            if (total - needed > HEADER) {
+                freeChunks[at + needed] = total - needed;
+                current = needed;
+            } else current = total;
+            return at;
+        }
+        free(at);
+        return alloc(size);
+    }
+
+    size_t freeBytes() const {
+        size_t total = 0;
+        for (const auto& chunk : freeChunks) total += chunk.second;
+        return total;
+    }
+
+    size_t largestFree() const {
+        size_t largest = 0;
+        for (const auto& chunk : freeChunks) if (chunk.second > largest) largest = chunk.second;
+        return largest;
+    }
+};
+
+// The heap side of the previous design: `new DayJob` per scheduled job and the debug clock line
+// rebuilt with String concatenation every second.
+struct HeapModel {
+    // vtable pointer, isSystem, Time, task pointer
+    static const size_t AVR_DAY_JOB_SIZE = 2 + 1 + 4 + 2;
+
+    AvrHeap heap;
+    std::map<uint16_t, size_t> jobs;
+    size_t clock = 0;
+    bool hasClock = false;
+
+    void schedule(uint16_t id) { jobs[id] = heap.alloc(AVR_DAY_JOB_SIZE); }
+
+    void unschedule(uint16_t id) {
+        heap.free(jobs[id]);
+        jobs.erase(id);
+    }
+
+    // "h:m:s" grown one concat at a time, each reserving exactly the new length plus the NUL,
+    // then copied into the static String, which only grows
+    void tick(const Time& time) {
+        char parts[5][4];
+        snprintf(parts[0], 4, "%u", time.hours());
+        snprintf(parts[2], 4, "%u", time.minutes());
+        snprintf(parts[4], 4, "%u", time.seconds());
+        strcpy(parts[1], ":");
+        strcpy(parts[3], ":");
+
+        size_t line = 0, length = 0;
+        for (uint8_t i = 0; i < 5; ++i) {
+            line = heap.realloc(line, length + strlen(parts[i]) + 1, i > 0);
+            length += strlen(parts[i]);
+        }
+        clock = heap.realloc(clock, length + 1, hasClock);
+        hasClock = true;
+        heap.free(line);
+    }
+};
+
+void printHeap(const char* name, size_t freeBytes, size_t largest, size_t top) {
+    const auto fragmentation = freeBytes ? 100.0 * (1.0 - (double)largest / freeBytes) : 0.0;
+    printf("%-28s %8zu %10zu %12zu %15.1f%%\n", name, freeBytes, largest, top, fragmentation);
+}
+
+}
+
+void* operator new(size_t size) {
+    if (isFirmwareRunning) heapAllocations++;
+    if (void* memory = malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept { free(memory); }
+void operator delete(void* memory, size_t) noexcept { free(memory); }
+
+int main(int argc, char** argv) {
+    uint32_t operations = 200000;
+    uint32_t seed = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--operations") && i + 1 < argc) operations = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = strtoul(argv[++i], nullptr, 10);
+        else {
+            fprintf(stderr, "usage: %s [--operations N] [--seed S]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    sim::board.reset();
+    setup();
+
+    std::mt19937 random{seed};
+    std::vector<uint16_t> issued;
+    std::map<uint16_t, bool> isLive;
+    HeapModel model;
+    uint32_t scheduled = 0, full = 0, unscheduled = 0, staleRejected = 0, errors = 0;
+    uint8_t lastSecond = 0xFF;
+
+    for (uint32_t i = 0; i < operations; ++i) {
+        sim::board.advanceMs(random() % 2000);
+        runFirmware(loop);
+
+        const auto now = Time::now();
+        if (now.seconds() != lastSecond) {
+            lastSecond = now.seconds();
+            model.tick(now);
+        }
+
+        uint8_t live = 0;
+        for (const auto& entry : isLive) live += entry.second;
+        // keeps the table around half full, so both requests mostly succeed
+        if (random() % Program::JobsScheduler::MAX_JOBS >= live) {
+            const auto reply = request(BinaryProtocol::SCHEDULE_JOB,
+                                       {(uint8_t)(random() % 24), (uint8_t)(random() % 60), (uint8_t)(random() % 60)});
+            if (reply.status != BinaryProtocol::OK) {
+                full++;
+                continue;
+            }
+            const uint16_t id = reply.payload[0] | reply.payload[1] << 8;
+            if (isLive[id]) errors++;
+            isLive[id] = true;
+            issued.push_back(id);
+            model.schedule(id);
+            scheduled++;
+            continue;
+        }
+
+        // every other request names a live job, the rest any id ever handed out
+        uint16_t id = issued[random() % issued.size()];
+        if (random() % 2) {
+            while (!isLive[id]) id = issued[random() % issued.size()];
+        }
+        const auto reply = request(BinaryProtocol::UNSCHEDULE_JOB, {(uint8_t)id, (uint8_t)(id >> 8)});
+        const auto isAccepted = reply.status == BinaryProtocol::OK;
+        if (isAccepted != isLive[id]) errors++;
+        if (!isAccepted) {
+            staleRejected++;
+            continue;
+        }
+        isLive[id] = false;
+        model.unschedule(id);
+        unscheduled++;
+    }
+
+    const auto& pool = program->userJobs;
+    const auto listed = request(BinaryProtocol::LIST_JOBS, {});
+    uint8_t live = 0;
+    for (const auto& entry : isLive) live += entry.second;
+
+    printf("operations: %u (seed %u)\n", operations, seed);
+    printf("scheduled: %u, rejected for a full table or a taken time: %u\n", scheduled, full);
+    printf("unscheduled: %u, stale ids rejected: %u\n", unscheduled, staleRejected);
+    printf("ids that resolved to the wrong job or were wrongly refused: %u\n", errors);
+    printf("live jobs: %u (pool %u of %u slots used, %u listed)\n",
+           live, pool.used(), pool.capacity(), listed.payload.empty() ? 0 : listed.payload[0]);
+    printf("heap allocations by the firmware after setup: %zu\n\n", heapAllocations);
+
+    printf("%-28s %8s %10s %12s %16s\n", "user job memory", "free", "largest", "heap top", "fragmentation");
+    printHeap("new/delete (AVR model)", model.heap.freeBytes(), model.heap.largestFree(), model.heap.brk);
+    printf("%-28s %8s %10s %12zu\n", "  high water", "", "", model.heap.highWater);
+    printf("pool: %u of %u slots free, each fits any job; %zu bytes reserved on the host, no heap\n",
+           pool.capacity() - pool.used(), pool.capacity(), sizeof(pool));
+    return errors ? 1 : 0;
+}
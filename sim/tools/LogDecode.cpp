@@ -0,0 +1,46 @@
+// Decodes a captured serial stream from the feeder into text.
+//
+//   LogDecode [--sources DIR]... [capture.bin]
+//
+// Message literals are looked up in src/ and lib/ of this checkout unless --sources is given.
+
+#include "../LogDecoder.h"
+
+#include <cstdio>
+#include <cstring>
+
+int main(int argc, char** argv) {
+    sim::LogDecoder decoder;
+    const char* input = nullptr;
+    bool hasSources = false;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--sources") && i + 1 < argc) {
+            decoder.index(argv[++i]);
+            hasSources = true;
+        } else if (!input && argv[i][0] != '-') input = argv[i];
+        else {
+            fprintf(stderr, "usage: %s [--sources DIR]... [capture.bin]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (!hasSources) {
+        decoder.index(PETFEEDER_SOURCE_DIR "/src");
+        decoder.index(PETFEEDER_SOURCE_DIR "/lib");
+    }
+    for (const auto& collision : decoder.collisions()) fprintf(stderr, "hash collision: %s\n", collision.c_str());
+
+    FILE* file = input ? fopen(input, "rb") : stdin;
+    if (!file) {
+        perror(input);
+        return 1;
+    }
+
+    uint8_t buffer[4096];
+    size_t count;
+    while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        decoder.feed(buffer, count, [](const std::string& line) { printf("%s\n", line.c_str()); });
+    }
+    if (file != stdin) fclose(file);
+    return 0;
+}
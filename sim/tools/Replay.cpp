@@ -0,0 +1,163 @@
+// Replays an input trace through the firmware on the virtual clock, as fast as the host allows,
+// and checks what it drove against a golden run.
+//
+//   Replay CAPTURE [--golden FILE | --write-golden FILE] [--pass-us N] [--tail-ms N | --until-ms N]
+//
+// CAPTURE is the serial output of a firmware built with INPUT_TRACE (PetFeederSimTrace --capture
+// FILE, or what a capture build on the feeder sent); only its trace frames are used. The firmware
+// here is built without tracing and boots from the traced EEPROM and pin levels. Every serial
+// byte is made available at the ms it was read, every button level at the ms its interrupt
+// stamped it, and sleeps end exactly at the next of them (Board::exactSleep), so a replay is the
+// same every time. A loop pass that did not sleep costs --pass-us of virtual time.
+//
+// The outputs (servo writes, pin levels, serial bytes; see Board::outputLog) are compared with
+// --golden line by line, and the first difference is shown; --write-golden saves them instead.
+// The replay runs --tail-ms past the last input, so that moves it started can finish, or up to
+// --until-ms since boot to cover the scheduled jobs of a quiet stretch as well.
+
+#include "../../src/main.cpp"
+#include "../TraceDecoder.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+struct Options {
+    const char* capture = nullptr;
+    const char* golden = nullptr;
+    const char* writeGolden = nullptr;
+    uint32_t passUs = 100;
+    uint64_t tailMs = 60000;
+    uint64_t untilMs = 0;
+};
+
+Options parse(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--golden") && i + 1 < argc) options.golden = argv[++i];
+        else if (!strcmp(argv[i], "--write-golden") && i + 1 < argc) options.writeGolden = argv[++i];
+        else if (!strcmp(argv[i], "--pass-us") && i + 1 < argc) options.passUs = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--tail-ms") && i + 1 < argc) options.tailMs = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--until-ms") && i + 1 < argc) options.untilMs = strtoull(argv[++i], nullptr, 10);
+        else if (!options.capture && argv[i][0] != '-') options.capture = argv[i];
+        else {
+            options.capture = nullptr;
+            break;
+        }
+    }
+    if (!options.capture || (options.golden && options.writeGolden)) {
+        fprintf(stderr, "usage: %s CAPTURE [--golden FILE | --write-golden FILE] [--pass-us N] [--tail-ms N | --until-ms N]\n",
+                argv[0]);
+        exit(2);
+    }
+    if (!options.passUs) options.passUs = 1;
+    return options;
+}
+
+uint64_t nextOf(const std::vector<sim::TraceDecoder::Input>& inputs, size_t from, sim::TraceDecoder::Input::Kind kind) {
+    for (auto i = from; i < inputs.size(); ++i) {
+        if (inputs[i].kind == kind) return inputs[i].atMs * 1000;
+    }
+    return UINT64_MAX;
+}
+
+// The 1-based line where the outputs first differ, 0 if they do not.
+size_t firstDifference(const std::string& outputs, const std::string& golden, std::string& got, std::string& expected) {
+    std::istringstream gotLines(outputs), expectedLines(golden);
+    for (size_t line = 1;; ++line) {
+        const auto hasGot = (bool)std::getline(gotLines, got);
+        const auto hasExpected = (bool)std::getline(expectedLines, expected);
+        if (!hasGot && !hasExpected) return 0;
+        if (!hasGot) got = "(end)";
+        if (!hasExpected) expected = "(end)";
+        if (!hasGot || !hasExpected || got != expected) return line;
+    }
+}
+
+}
+
+int main(int argc, char** argv) {
+    const auto options = parse(argc, argv);
+
+    sim::TraceDecoder trace;
+    if (!trace.load(options.capture)) {
+        fprintf(stderr, "cannot read %s\n", options.capture);
+        return 1;
+    }
+    printf("trace:     %zu inputs over %.1f s, %zu boot levels, EEPROM %s\n", trace.inputs.size(),
+           trace.inputs.empty() ? 0.0 : trace.inputs.back().atMs / 1e3, trace.bootLevels.size(),
+           trace.hasEeprom() ? "captured" : "MISSING, booting erased");
+    if (trace.missingFrames || trace.badFrames || trace.lostRecords) {
+        printf("trace:     INCOMPLETE, %u frames missing, %u bad, %u records lost on the feeder\n",
+               trace.missingFrames, trace.badFrames, trace.lostRecords);
+    }
+
+    std::string outputs;
+    sim::board.reset();
+    sim::board.sleepEnabled = true;
+    sim::board.exactSleep = true;
+    sim::board.outputLog = &outputs;
+    if (trace.hasEeprom()) memcpy(sim::eeprom.cells, trace.eeprom, sim::Eeprom::SIZE);
+    for (const auto& level : trace.bootLevels) sim::board.setLevel(level.pin, level.isHigh);
+
+    const auto wallStart = std::chrono::steady_clock::now();
+    setup();
+
+    const auto& inputs = trace.inputs;
+    const auto endMs = options.untilMs ? options.untilMs : (inputs.empty() ? 0 : inputs.back().atMs) + options.tailMs;
+    size_t next = 0;
+    uint64_t passes = 0;
+    while (sim::board.micros / 1000 < endMs) {
+        for (; next < inputs.size() && inputs[next].atMs * 1000 <= sim::board.micros; ++next) {
+            const auto& input = inputs[next];
+            if (input.kind == sim::TraceDecoder::Input::SERIAL) sim::board.rx.push_back(input.value);
+            else sim::board.setLevel(input.pin, input.value);
+        }
+        sim::board.nextPinChangeAt = nextOf(inputs, next, sim::TraceDecoder::Input::PIN);
+        sim::board.nextRxAt = nextOf(inputs, next, sim::TraceDecoder::Input::SERIAL);
+
+        const auto passStart = sim::board.micros;
+        loop();
+        ++passes;
+        if (sim::board.micros == passStart) sim::board.advance(options.passUs);
+    }
+    const auto wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+    const auto simulatedSeconds = sim::board.micros / 1e6;
+    size_t lines = 0;
+    for (const auto value : outputs) lines += value == '\n';
+    printf("replayed:  %.0f s in %.3f s (%.0fx real time, %llu loop passes)\n", simulatedSeconds, wallSeconds,
+           simulatedSeconds / wallSeconds, (unsigned long long)passes);
+    printf("outputs:   %zu lines, %u servo writes, %zu serial bytes\n", lines, sim::board.servoWrites, sim::board.tx.size());
+
+    if (options.writeGolden) {
+        std::ofstream file(options.writeGolden, std::ios::binary);
+        file << outputs;
+        if (!file) {
+            fprintf(stderr, "cannot write %s\n", options.writeGolden);
+            return 1;
+        }
+        printf("golden:    written to %s\n", options.writeGolden);
+        return 0;
+    }
+    if (!options.golden) return 0;
+
+    std::ifstream file(options.golden, std::ios::binary);
+    if (!file) {
+        fprintf(stderr, "cannot read %s\n", options.golden);
+        return 1;
+    }
+    const std::string golden{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    std::string got, expected;
+    const auto line = firstDifference(outputs, golden, got, expected);
+    if (!line) {
+        printf("golden:    match\n");
+        return 0;
+    }
+    printf("golden:    DIFFERS at line %zu\n  expected: %s\n  got:      %s\n", line, expected.c_str(), got.c_str());
+    return 1;
+}
@@ -0,0 +1,191 @@
+// Checks recurrence rules (see Recurrence in src/main.cpp) and what they save over daily jobs.
+//
+//   RuleCheck [--rules N] [--seed S]
+//
+//  - next occurrence: for N random rules and times of the week, Recurrence::msAfter must agree
+//    with a search through every occurrence of the week, listed one by one.
+//  - a week of feeding: the firmware gets a weekday rule over the serial interface and runs a
+//    week on the virtual clock; every day must see the openings the rule asks for, no others.
+//  - out of range: `sjr` with an interval or end past the last minute of the day must be
+//    rejected, the job keeping its rule, rather than stored as whatever fits the rule's fields.
+//  - memory: bytes for common schedules as one rule against the equivalent list of daily
+//    DayJobs, AVR sizes, and whether that list fits the job table at all.
+
+#define LOG_LEVEL LOG_LEVEL_NONE
+#include "../../src/main.cpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+const uint8_t SERVO_PIN = 9;
+const uint8_t WEEKDAYS = 0b0011111;
+
+// Every occurrence of the week, in ms since Monday 00:00.
+std::vector<uint32_t> occurrences(const Time& start, const Recurrence& rule) {
+    std::vector<uint32_t> all;
+    for (uint8_t day = 0; day < 7; ++day) {
+        if (!(rule.weekdays >> day & 1)) continue;
+        for (uint32_t atMs = start.toMs(); atMs < Time::DAY_MS; atMs += rule.intervalMin * 60000UL) {
+            if (atMs != start.toMs() && atMs > rule.endMin * 60000UL) break;
+            all.push_back(day * Time::DAY_MS + atMs);
+            if (!rule.intervalMin) break;
+        }
+    }
+    return all;
+}
+
+uint32_t searchAfter(const std::vector<uint32_t>& all, uint32_t fromMs) {
+    if (all.empty()) return Recurrence::NEVER;
+    const auto next = std::upper_bound(all.begin(), all.end(), fromMs);
+    return next == all.end() ? Time::WEEK_MS - fromMs + all.front() : *next - fromMs;
+}
+
+bool checkNext(uint32_t rules, std::mt19937& random) {
+    uint32_t mismatches = 0, checks = 0;
+    for (uint32_t i = 0; i < rules; ++i) {
+        const auto start = Time(random() % Time::DAY_MS / 1000 * 1000);
+        const Recurrence rule{(uint8_t)(random() % 128), (uint16_t)(random() % 3 ? random() % 240 : 0),
+                              (uint16_t)(random() % (Recurrence::MAX_MINUTE + 1))};
+        const auto all = occurrences(start, rule);
+        for (uint8_t j = 0; j < 50; ++j) {
+            // half of the probes on or next to an occurrence
+            uint32_t fromMs = random() % Time::WEEK_MS;
+            if (!all.empty() && random() % 2) fromMs = (all[random() % all.size()] + Time::WEEK_MS - random() % 3) % Time::WEEK_MS;
+            checks++;
+            if (rule.msAfter(start, fromMs) == searchAfter(all, fromMs)) continue;
+            if (!mismatches++) {
+                printf("next occurrence: MISMATCH start %u ms, rule %02x/%u/%u, from %u: %u, expected %u\n",
+                       start.toMs(), rule.weekdays, rule.intervalMin, rule.endMin, fromMs,
+                       rule.msAfter(start, fromMs), searchAfter(all, fromMs));
+            }
+        }
+    }
+    printf("next occurrence: %u rules, %u times of the week, %u disagree with the search\n", rules, checks, mismatches);
+    return !mismatches;
+}
+
+void run(const char* line) {
+    program->commandInterpreter.interpret(line, *program);
+    loop();
+}
+
+bool checkWeek() {
+    sim::board.reset();
+    sim::board.sleepEnabled = true;
+    sim::board.exactSleep = true;
+    sim::eeprom.erase();
+    Time::set(Time());
+    Time::setWeekday(0);
+    setup();
+
+    // Monday 06:00; weekdays 07:00 to 19:00 every 90 min, and Sunday 10:00 only
+    run("sti,21600000");
+    run("swd,0");
+    run("scj,7,0,0");
+    run("sjr,256,31,90,1140");
+    run("scj,10,0,0");
+    run("sjr,257,64,0,0");
+
+    const uint8_t expected[7] = {9, 9, 9, 9, 9, 0, 1};
+    uint8_t openings[7]{};
+    auto wasOpen = false;
+    const auto endMs = millis() + 7 * Time::DAY_MS;
+    while (millis() < endMs) {
+        const auto passStart = sim::board.micros;
+        loop();
+        if (sim::board.micros == passStart) sim::board.advance(100);
+
+        const auto isOpen = sim::board.servoAngles[SERVO_PIN] > 0;
+        if (isOpen && !wasOpen) openings[Time::weekday()]++;
+        wasOpen = isOpen;
+    }
+
+    auto isOk = true;
+    printf("a week of feeding:");
+    for (uint8_t day = 0; day < 7; ++day) {
+        printf(" %u", openings[day]);
+        isOk = isOk && openings[day] == expected[day];
+    }
+    printf(" openings Monday to Sunday, %s\n", isOk ? "as the rules say" : "WRONG");
+    delete program;
+    return isOk;
+}
+
+bool checkOutOfRange() {
+    sim::board.reset();
+    sim::eeprom.erase();
+    setup();
+
+    run("scj,7,0,0");
+    const char* const lines[] = {"sjr,256,127,3000,0", "sjr,256,127,30,2000", "sjr,256,127,1440,0"};
+    uint8_t taken = 0;
+    for (const auto line : lines) {
+        run(line);
+        const auto job = program->userJobs.get(256);
+        if (!job || !job->rule.isDaily()) taken++;
+    }
+    printf("out of range: %zu rules sent, %u taken\n", sizeof(lines) / sizeof(lines[0]), taken);
+    delete program;
+    return !taken;
+}
+
+// AVR sizes: the job itself (isSystem, Time, task, the rule where there is one, version), its pool generation byte, the scheduler's pointer and its dispense profile
+const size_t AVR_RULE_JOB = 1 + 4 + 2 + sizeof(Recurrence) + 2 + 1 + 2 + sizeof(DispenseProfile);
+const size_t AVR_DAILY_JOB = 1 + 4 + 2 + 2 + 1 + 2 + sizeof(DispenseProfile);
+
+void printMemory() {
+    const struct {
+        const char* name;
+        Time start;
+        Recurrence rule;
+    } schedules[] = {
+            {"07:00-19:00 every 90 min", Time::of(7, 0), {Recurrence::EVERY_DAY, 90, 19 * 60}},
+            {"every 4 hours", Time::of(0, 0), {Recurrence::EVERY_DAY, 240, Recurrence::MAX_MINUTE}},
+            {"06:00-22:00 every 30 min", Time::of(6, 0), {Recurrence::EVERY_DAY, 30, 22 * 60}},
+            {"weekdays at 07:30", Time::of(7, 30), {WEEKDAYS}},
+            {"weekdays 07:00-19:00/90 min", Time::of(7, 0), {WEEKDAYS, 90, 19 * 60}},
+    };
+
+    printf("\n%-28s %9s %10s %15s\n", "schedule", "per week", "as a rule", "as daily jobs");
+    for (const auto& schedule : schedules) {
+        const auto perWeek = occurrences(schedule.start, schedule.rule).size();
+        // a size_t in decimal, " B" and the note
+        char expanded[20 + 2 + 11 + 1];
+        if (schedule.rule.weekdays != Recurrence::EVERY_DAY) snprintf(expanded, sizeof(expanded), "impossible");
+        else {
+            const auto jobs = perWeek / 7;
+            snprintf(expanded, sizeof(expanded), "%zu B%s", jobs * AVR_DAILY_JOB,
+                     jobs > Program::JobsScheduler::MAX_JOBS ? " (too many)" : "");
+        }
+        printf("%-28s %9zu %8zu B %15s\n", schedule.name, perWeek, AVR_RULE_JOB, expanded);
+    }
+    printf("a rule is %zu bytes on top of the job; a job with one takes %zu B, a daily one %zu B\n",
+           sizeof(Recurrence), AVR_RULE_JOB, AVR_DAILY_JOB);
+}
+
+}
+
+int main(int argc, char** argv) {
+    uint32_t rules = 20000;
+    uint32_t seed = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--rules") && i + 1 < argc) rules = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = strtoul(argv[++i], nullptr, 10);
+        else {
+            fprintf(stderr, "usage: %s [--rules N] [--seed S]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::mt19937 random{seed};
+    auto isOk = checkNext(rules, random);
+    isOk = checkWeek() && isOk;
+    isOk = checkOutOfRange() && isOk;
+    printMemory();
+    return isOk ? 0 : 1;
+}
@@ -0,0 +1,102 @@
+// Timer1 interrupt load of the servo over a day of feeding, with the idle detach of ServoRotator
+// and with the servo attached for good, as it used to be.
+//
+//   ServoLoad [--pass-us N]
+//
+// The loop runs every ms, as without sleep. While a servo is attached the Servo library takes an
+// interrupt at the start of every 20 ms frame and one at the end of the pulse, about
+// ISR_US each; a loop pass of --pass-us (on the AVR) that one lands in is delayed by it. The
+// figures are modelled from when the servo was attached and what it was commanded to.
+
+#define LOG_LEVEL LOG_LEVEL_NONE
+#include "../../src/main.cpp"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+const uint8_t SERVO_PIN = 9;
+const uint32_t FRAME_US = 20000;
+// about 100 cycles at 16 MHz, entry and exit included
+const uint32_t ISR_US = 6;
+const uint64_t DAY_MS = 24ULL * 60 * 60 * 1000;
+
+// Pulse width the Servo library sends for an angle (544..2400 us).
+uint32_t pulseUs(int16_t angle) { return 544 + (uint32_t)angle * (2400 - 544) / 180; }
+
+struct Load {
+    uint64_t attachedUs = 0;
+    uint64_t interrupts = 0;
+    uint64_t passes = 0;
+    uint64_t delayedPasses = 0;
+    uint32_t worstDelayUs = 0;
+    uint32_t writes = 0;
+};
+
+// Feeding times of the day, the last one with a three-shake profile.
+const struct { uint8_t hours, minutes; DispenseProfile profile; } FEEDINGS[] = {
+        {7, 30, {180, 1, 1000}},
+        {12, 0, {180, 1, 1000}},
+        {18, 30, {180, 1, 1000}},
+        {21, 0, {120, 3, 400}},
+};
+
+Load run(uint16_t idleDetachMs, uint32_t passUs) {
+    sim::board.reset();
+    ServoRotator rotator{SERVO_PIN, idleDetachMs};
+    Load load;
+    uint8_t nextFeeding = 0;
+
+    for (uint64_t ms = 0; ms < DAY_MS; ++ms) {
+        sim::board.micros = ms * 1000;
+        if (nextFeeding < sizeof(FEEDINGS) / sizeof(FEEDINGS[0])
+                && ms == (FEEDINGS[nextFeeding].hours * 60ULL + FEEDINGS[nextFeeding].minutes) * 60000) {
+            rotator.dispense(FEEDINGS[nextFeeding++].profile);
+        }
+        rotator.react();
+        load.passes++;
+
+        if (!rotator.isAttached()) continue;
+        // the interrupts of the frame this pass falls in, against the pass
+        const auto passStart = sim::board.micros;
+        const auto frameStart = passStart / FRAME_US * FRAME_US;
+        uint32_t delayUs = 0;
+        for (const auto at : {frameStart, frameStart + pulseUs(sim::board.servoAngles[SERVO_PIN]), frameStart + FRAME_US}) {
+            if (at >= passStart && at < passStart + passUs) delayUs += ISR_US;
+        }
+        if (delayUs) load.delayedPasses++;
+        if (delayUs > load.worstDelayUs) load.worstDelayUs = delayUs;
+    }
+
+    sim::board.micros = DAY_MS * 1000;
+    load.attachedUs = sim::board.servoAttachedTime();
+    load.interrupts = load.attachedUs / FRAME_US * 2;
+    load.writes = sim::board.servoWrites;
+    return load;
+}
+
+void print(const char* name, const Load& load) {
+    printf("%-22s %9.3f%% %12llu %9.4f%% %10.4f%% %8u us %8u\n", name,
+           100.0 * load.attachedUs / (DAY_MS * 1000), (unsigned long long)load.interrupts,
+           100.0 * load.interrupts * ISR_US / (DAY_MS * 1000), 100.0 * load.delayedPasses / load.passes,
+           load.worstDelayUs, load.writes);
+}
+
+}
+
+int main(int argc, char** argv) {
+    uint32_t passUs = 40;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--pass-us") && i + 1 < argc) passUs = strtoul(argv[++i], nullptr, 10);
+        else {
+            fprintf(stderr, "usage: %s [--pass-us N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    printf("%-22s %10s %12s %10s %11s %11s %8s\n", "servo", "attached", "timer ISRs", "ISR load", "passes hit", "worst", "writes");
+    print("always attached", run(0, passUs));
+    print("idle detach", run(ServoRotator::IDLE_DETACH_MS, passUs));
+    return 0;
+}
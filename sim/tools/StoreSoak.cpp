@@ -0,0 +1,206 @@
+// Exercises the EEPROM schedule store on the host's EEPROM stand-in (see sim/include/EEPROM.h).
+//
+//   StoreSoak [--updates N] [--seed S]
+//
+//  - reset: the firmware schedules jobs, is reset, and must come back with the same job table,
+//    the same job ids and the clock where it was saved.
+//  - wear: N random updates of the job and clock records straight through the record log: records
+//    written per update that changed something (write amplification), EEPROM cycles of the most
+//    worn cell against rewriting each value at a fixed address, and the host time of a restore.
+//  - power loss: writes cut short after a random number of bytes must leave every key at its old
+//    or, for the key being written, its new value.
+
+#define LOG_LEVEL LOG_LEVEL_NONE
+#include "../../src/main.cpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+const uint8_t KEYS = 1 + Program::JobsScheduler::MAX_JOBS;
+typedef RecordLog<0, sim::Eeprom::SIZE, KEYS> Log;
+
+struct Entry {
+    uint8_t tag;
+    uint32_t value;
+
+    bool operator==(const Entry& other) const { return tag == other.tag && value == other.value; }
+};
+
+void run(const char* line) {
+    program->commandInterpreter.interpret(line, *program);
+    loop();
+}
+
+// Every scheduled job as "id@ms".
+std::vector<uint32_t> jobTable() {
+    std::vector<uint32_t> table;
+    for (const auto job : program->jobsScheduler.getJobs()) {
+        table.push_back(program->userJobs.handleOf(job));
+        table.push_back(job->time.toMs());
+    }
+    return table;
+}
+
+void reboot() {
+    delete program;
+    sim::board.reset();
+    // RAM does not survive a reset; the clock starts at midnight until something sets it
+    Time::set(Time());
+    setup();
+}
+
+bool checkReset() {
+    run("sti,27000000");
+    run("scj,7,30,0");
+    run("scj,12,0,0");
+    run("scj,18,30,0");
+    run("usj,257");
+    run("scj,21,0,0");
+    sim::board.advanceMs(15UL * 60 * 1000);
+    loop();
+
+    const auto before = jobTable();
+    const auto clockBefore = Time::nowMs();
+    reboot();
+    const auto after = jobTable();
+    const auto clockAfter = Time::nowMs();
+
+    printf("reset: %zu jobs before, %zu after, %s; clock %u ms before, %u ms after\n",
+           before.size() / 2, after.size() / 2, before == after ? "ids and times match" : "MISMATCH",
+           clockBefore, clockAfter);
+    run("scj,7,30,0");
+    const auto isDuplicateRejected = jobTable().size() == after.size();
+    printf("reset: a restored job's time cannot be scheduled twice: %s\n", isDuplicateRejected ? "yes" : "NO");
+    return before == after && isDuplicateRejected && clockBefore - clockAfter <= Program::Store::CLOCK_CHECKPOINT_MS;
+}
+
+Entry randomUpdate(std::mt19937& random, uint8_t key, const Entry& current) {
+    // a third of the job updates re-save what is stored already
+    if (key && random() % 3 == 0) return current;
+    if (!key) return {0, (uint32_t)(current.value + 10UL * 60 * 1000) % Time::DAY_MS};
+    if (current.value == Program::Store::EMPTY) return {current.tag, (uint32_t)(random() % Time::DAY_MS)};
+    return {(uint8_t)(current.tag + 1 ? current.tag + 1 : 1), Program::Store::EMPTY};
+}
+
+bool checkWear(uint32_t updates, std::mt19937& random) {
+    sim::eeprom.erase();
+    sim::eeprom.resetCounters();
+
+    Log log;
+    log.restore();
+    std::vector<Entry> stored(KEYS, Entry{1, Program::Store::EMPTY});
+    std::vector<uint32_t> fixedCellWrites(KEYS, 0);
+    uint32_t changes = 0;
+
+    for (uint32_t i = 0; i < updates; ++i) {
+        // the clock is saved about as often as all job changes together
+        const uint8_t key = random() % 2 ? 0 : 1 + random() % (KEYS - 1);
+        const auto update = randomUpdate(random, key, stored[key]);
+        if (!(update == stored[key])) {
+            changes++;
+            fixedCellWrites[key]++;
+        }
+        log.write(key, update.tag, update.value);
+        stored[key] = update;
+    }
+
+    uint32_t mostWorn = 0;
+    uint64_t totalCycles = 0;
+    for (const auto cycles : sim::eeprom.cycles) {
+        if (cycles > mostWorn) mostWorn = cycles;
+        totalCycles += cycles;
+    }
+    uint32_t hottestKey = 0;
+    for (const auto writes : fixedCellWrites) if (writes > hottestKey) hottestKey = writes;
+
+    printf("wear: %u updates, %u changed a value, %u records written (%u moved by compaction)\n",
+           updates, changes, log.written, log.moved);
+    printf("wear: write amplification %.3f records per change, %.2f EEPROM bytes per change\n",
+           (double)log.written / changes, (double)sim::eeprom.writes / changes);
+    printf("wear: most worn cell %u cycles, mean %.0f over %u slots; fixed addresses would put %u on the clock's\n",
+           mostWorn, (double)totalCycles / sim::Eeprom::SIZE, Log::SLOTS, hottestKey);
+    printf("wear: 100k-cycle cells last %.0f changes in the ring, %.0f at fixed addresses\n",
+           100000.0 * changes / mostWorn, 100000.0 * changes / hottestKey);
+
+    auto isRestored = true;
+    const uint32_t restores = 20000;
+    Log restored;
+    const auto readsBefore = sim::eeprom.reads;
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < restores; ++i) restored.restore();
+    const auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    for (uint8_t key = 0; key < KEYS; ++key) {
+        Entry entry{};
+        if (!restored.read(key, entry.tag, entry.value) || !(entry == stored[key])) isRestored = false;
+    }
+    printf("restore: %.2f us on the host, %llu EEPROM reads, every key %s\n",
+           elapsed / restores, (unsigned long long)(sim::eeprom.reads - readsBefore) / restores,
+           isRestored ? "restored" : "WRONG");
+    return isRestored;
+}
+
+bool checkPowerLoss(uint32_t trials, std::mt19937& random) {
+    sim::eeprom.erase();
+    Log log;
+    log.restore();
+    std::vector<Entry> stored(KEYS, Entry{1, Program::Store::EMPTY});
+    uint32_t torn = 0, failures = 0;
+
+    for (uint32_t i = 0; i < trials; ++i) {
+        const uint8_t key = random() % KEYS;
+        const auto update = randomUpdate(random, key, stored[key]);
+
+        sim::eeprom.writesUntilPowerLoss = random() % 24;
+        const auto writesBefore = sim::eeprom.writes;
+        log.write(key, update.tag, update.value);
+        const auto isTorn = sim::eeprom.writesUntilPowerLoss == 0;
+        sim::eeprom.writesUntilPowerLoss = -1;
+        if (isTorn && sim::eeprom.writes != writesBefore) torn++;
+
+        // power back: whatever made it to the EEPROM is all there is
+        log = Log{};
+        log.restore();
+        for (uint8_t other = 0; other < KEYS; ++other) {
+            Entry entry{1, Program::Store::EMPTY};
+            log.read(other, entry.tag, entry.value);
+            if (entry == stored[other] || (other == key && entry == update)) continue;
+            failures++;
+            break;
+        }
+        Entry entry{1, Program::Store::EMPTY};
+        log.read(key, entry.tag, entry.value);
+        stored[key] = entry;
+    }
+
+    printf("power loss: %u writes, %u cut short, %u left a key at neither its old nor new value\n",
+           trials, torn, failures);
+    return !failures;
+}
+
+}
+
+int main(int argc, char** argv) {
+    uint32_t updates = 2000000;
+    uint32_t seed = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--updates") && i + 1 < argc) updates = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = strtoul(argv[++i], nullptr, 10);
+        else {
+            fprintf(stderr, "usage: %s [--updates N] [--seed S]\n", argv[0]);
+            return 2;
+        }
+    }
+    sim::board.reset();
+    setup();
+
+    std::mt19937 random{seed};
+    auto isOk = checkReset();
+    isOk = checkWear(updates, random) && isOk;
+    isOk = checkPowerLoss(updates / 10, random) && isOk;
+    return isOk ? 0 : 1;
+}
@@ -0,0 +1,228 @@
+#pragma once
+
+/**
+ * The firmware's hot paths in CPU cycles on the ATmega32U4, for the avr_bench environment: built
+ * with `-D AVR_BENCH=1`, main.cpp includes this at its end in place of its setup() and loop(),
+ * so everything there is in reach. setup() runs every case once under CycleBench and stops;
+ * scripts/avr_bench.sh runs that under simavr and keeps the results.
+ *
+ * Cases are named without spaces, as the results file keys them. What a case needs in place
+ * (a clock a ms on, a deadline reached, a frame still encoded, the state a command changes put
+ * back) is done in its `prepare`, outside the count, so every run takes the same path. The build
+ * sets RECORD_LOG_DRY_RUN: the store lays its records out but leaves EEPROM alone, whose 3.3 ms a
+ * byte would overflow the count of every command that saves something. The scheduler cases come
+ * first, on a context of their own, so their 32 jobs have the heap to themselves before Program
+ * takes it.
+ */
+
+#include <CycleBench.h>
+
+// wiring.c's count behind millis(): moved on directly, so the clock and deadlines get where a
+// case needs them without waiting
+extern volatile unsigned long timer0_millis;
+
+namespace benchmarks {
+
+const uint8_t RUNS = 16;
+
+void advanceMs(uint32_t ms) {
+    const uint8_t sreg = SREG;
+    cli();
+    timer0_millis += ms;
+    SREG = sreg;
+}
+
+uint32_t sampleMs = 0;
+
+void clock() {
+    CycleBench::run(F("Time::fromMs"), RUNS, [] { sampleMs += 37 * 60000UL + 1234; }, [] {
+        CycleBench::keep(Time::fromMs(sampleMs));
+    });
+    CycleBench::run(F("Time::now"), RUNS, [] { advanceMs(1); }, [] { CycleBench::keep(Time::now()); });
+
+    // as after a sync: a rate at work and an offset being slewed in
+    Time::setRate(-3000);
+    Time::adjust(500);
+    CycleBench::run(F("Time::now.corrected"), RUNS, [] { advanceMs(1); }, [] { CycleBench::keep(Time::now()); });
+    Time::adjust(0);
+    Time::setRate(0);
+}
+
+template<uint8_t JOBS> struct SchedulerContext {
+    static void task(SchedulerContext&, const DayJob<SchedulerContext>&) {}
+
+    DayJobsScheduler<SchedulerContext, JOBS> jobsScheduler{*this};
+    Pool<DayJob<SchedulerContext>, JOBS> jobs;
+};
+
+// JOBS daily jobs spread over the day: a react() with nothing due, and one at a deadline, which
+// runs the job and arms the next.
+template<uint8_t JOBS>
+void scheduler(const __FlashStringHelper* idle, const __FlashStringHelper* due) {
+    auto context = new SchedulerContext<JOBS>();
+    for (uint8_t i = 0; i < JOBS; ++i) {
+        const auto handle = context->jobs.create(Time(i * (Time::DAY_MS / JOBS) + 1000), SchedulerContext<JOBS>::task);
+        context->jobsScheduler.schedule(context->jobs.get(handle));
+    }
+    context->jobsScheduler.react();
+
+    CycleBench::run(idle, RUNS, [context] { context->jobsScheduler.react(); });
+    CycleBench::run(due, RUNS, [context] { advanceMs(context->jobsScheduler.nextWake().inMs); }, [context] {
+        context->jobsScheduler.react();
+    });
+    delete context;
+}
+
+void command(const __FlashStringHelper* name, const char* line) {
+    CycleBench::run(name, RUNS, [line] { program->commandInterpreter.interpret(line, *program); });
+}
+
+template<typename TPrepare> void command(const __FlashStringHelper* name, const char* line, TPrepare prepare) {
+    CycleBench::run(name, RUNS, prepare, [line] { program->commandInterpreter.interpret(line, *program); });
+}
+
+// Every user job gone, as `usj` leaves them.
+void clearJobs() {
+    auto& jobs = program->userJobs;
+    for (uint8_t slot = 0; slot < jobs.capacity(); ++slot) {
+        const auto handle = jobs.handleAt(slot);
+        const auto job = jobs.get(handle);
+        if (!job) continue;
+        program->jobsScheduler.unschedule(job);
+        jobs.destroy(handle);
+    }
+}
+
+// The handle of the first user job, 0 without one.
+uint16_t firstJob() {
+    const auto& jobs = program->userJobs;
+    for (uint8_t slot = 0; slot < jobs.capacity(); ++slot) {
+        if (jobs.get(jobs.handleAt(slot))) return jobs.handleAt(slot);
+    }
+    return 0;
+}
+
+// Takes frames as they are sent, and replies as they would go out, without keeping them.
+struct FrameSink: Print {
+    uint8_t bytes[COMMAND_RESPONSE_SIZE + 4];
+    uint8_t length = 0;
+
+    size_t write(uint8_t value) override {
+        if (length < sizeof(bytes)) bytes[length++] = value;
+        return 1;
+    }
+    using Print::write;
+};
+
+// A request frame, encoded again before each run: the interpreter decodes it in place.
+void frame(const __FlashStringHelper* name, const uint8_t* body, uint8_t length) {
+    static FrameSink request;
+    static uint8_t encoded[sizeof(request.bytes)];
+    static uint8_t encodedLength;
+    static FrameSink reply;
+    request.length = 0;
+    BinaryProtocol::send(request, body, length);
+    // the listener hands over what is between the delimiters
+    encodedLength = request.length - 2;
+    CycleBench::run(name, RUNS, [] {
+        memcpy(encoded, request.bytes + 1, encodedLength);
+        reply.length = 0;
+    }, [] { program->commandInterpreter.interpretFrame(encoded, encodedLength, reply); });
+}
+
+void commands() {
+    command(F("interpret.sti"), "sti,43200000");
+    command(F("interpret.swd"), "swd,2");
+    command(F("interpret.scj"), "scj,7,30,0", [] { clearJobs(); });
+
+    // on the job the last run of `scj` left
+    static char line[32];
+    FORMAT(line, "sjp,{},90,500,2", firstJob());
+    command(F("interpret.sjp"), line);
+    FORMAT(line, "sjr,{},31,60,1200", firstJob());
+    command(F("interpret.sjr"), line);
+
+    command(F("interpret.gj"), "gj");
+    command(F("interpret.exp"), "exp,0,0");
+    command(F("interpret.mem"), "mem");
+    command(F("interpret.ser"), "ser");
+    command(F("interpret.syn"), "syn,43200000");
+    // a request open from the clock as `syn` found it, and no baseline yet
+    command(F("interpret.sya"), "sya,43200040", [] {
+        Time::set(Time(43200000));
+        program->clockSync = ClockSync();
+        program->clockSync.request(43200000);
+    });
+    command(F("interpret.usj"), line, [] {
+        clearJobs();
+        program->commandInterpreter.interpret("scj,7,30,0", *program);
+        FORMAT(line, "usj,{}", firstJob());
+    });
+    command(F("interpret.sbb"), "sbb");
+    command(F("interpret.sbj"), "sbj,25200000,0,0", [] { program->scheduleUpload.begin(); });
+    command(F("interpret.sbc"), "sbc,1", [] {
+        program->scheduleUpload.begin();
+        program->scheduleUpload.stage(25200000, 0, 0);
+    });
+    command(F("interpret.unknown"), "zzz,1");
+
+    const uint8_t setTime[] = {BinaryProtocol::SET_TIME, 0x2A, 0x00, 0x2E, 0x93, 0x02, 0, 0};
+    uint8_t body[sizeof(setTime)];
+    memcpy(body, setTime, sizeof(body));
+    const auto setTimeCrc = BinaryProtocol::crc16(body, sizeof(body) - BinaryProtocol::CRC_SIZE);
+    body[sizeof(body) - 2] = setTimeCrc;
+    body[sizeof(body) - 1] = setTimeCrc >> 8;
+    frame(F("interpretFrame.sti"), body, sizeof(body));
+
+    uint8_t listJobs[] = {BinaryProtocol::LIST_JOBS, 0x2A, 0, 0};
+    const auto listJobsCrc = BinaryProtocol::crc16(listJobs, 2);
+    listJobs[2] = listJobsCrc;
+    listJobs[3] = listJobsCrc >> 8;
+    frame(F("interpretFrame.gj"), listJobs, sizeof(listJobs));
+}
+
+// Serves one line over and over, as the serial port would have it in its buffer.
+struct LineStream: Stream {
+    const char* line = "";
+    uint8_t at = 0;
+
+    int available() override { return strlen(line + at); }
+    int read() override { return line[at] ? line[at++] : -1; }
+    int peek() override { return line[at] ? line[at] : -1; }
+    size_t write(uint8_t) override { return 1; }
+    using Print::write;
+};
+
+// A listener like Program's, handing lines to nothing: the assembly alone.
+void listener() {
+    static LineStream stream;
+    static StreamListener<Program, 32> listener{*program, stream, [](const char*, Program&) {}, "\r\n"};
+
+    stream.line = "sti,43200000\r\n";
+    CycleBench::run(F("StreamListener.line14"), RUNS, [] { stream.at = 0; }, [] { listener.react(); });
+    stream.line = "sbj,43200000,16909060,33620225\r\n";
+    CycleBench::run(F("StreamListener.line32"), RUNS, [] { stream.at = 0; }, [] { listener.react(); });
+    stream.line = "";
+    stream.at = 0;
+    CycleBench::run(F("StreamListener.idle"), RUNS, [] { listener.react(); });
+}
+
+}
+
+__attribute__((unused)) void setup() {
+    CycleBench::begin();
+
+    benchmarks::clock();
+    benchmarks::scheduler<1>(F("DayJobsScheduler::react.idle.1"), F("DayJobsScheduler::react.due.1"));
+    benchmarks::scheduler<10>(F("DayJobsScheduler::react.idle.10"), F("DayJobsScheduler::react.due.10"));
+    benchmarks::scheduler<32>(F("DayJobsScheduler::react.idle.32"), F("DayJobsScheduler::react.due.32"));
+
+    program = new Program();
+    benchmarks::commands();
+    benchmarks::listener();
+    CycleBench::run(F("Program::act.idle"), benchmarks::RUNS, [] { program->act(); });
+
+    CycleBench::end();
+}
+
+__attribute__((unused)) void loop() {}
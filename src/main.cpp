@@ -1,342 +1,1012 @@
 #include <Arduino.h>
 
-#include <../.pio/libdeps/sparkfun_promicro16/Servo/src/Servo.h> // that include is bad...
+// Jobs Program's scheduler holds, system jobs included. Its `gj` reply, a count and 7 bytes a job,
+// is the longest a command gives, and sizes every response frame.
+#ifndef SCHEDULER_JOBS
+#define SCHEDULER_JOBS 10
+#endif
+#define COMMAND_MAX_PAYLOAD (1 + SCHEDULER_JOBS * 7)
+
+#include <Servo.h>
+#include <BinaryProtocol.h>
+#include <CommandTable.h>
+#include <FixedContainers.h>
+#include <InputTrace.h>
+#include <Logger.h>
+#include <Memory.h>
+#include <PinEdges.h>
+#include <Pool.h>
+#include <Profiler.h>
+#include <RecordLog.h>
+#include <Sleep.h>
 
 // TODO: Separate functionalities into private libraries, pls soon...
 
 #define getMillisDiff(ms, prevMs) ((unsigned long)((ms) - (prevMs)))
 
-template<typename T> struct IComparable { virtual int8_t compareTo(const T*) const = 0; };
-template<typename T> struct IEquatable { virtual bool equals(const T*) const = 0; };
+Logger<LOG_LEVEL_MAX == LOG_LEVEL_NONE ? 1 : 128> logger;
+InputTrace<INPUT_TRACE ? 128 : 1> inputTrace;
+
+// What Program::act() times when built with PROFILER, numbered as `prf` takes them: the whole
+// pass, each component, the debug clock line and sending the log and trace.
+enum ProfileSection: uint8_t {
+    PROFILE_ACT, PROFILE_BUTTON, PROFILE_SERVO, PROFILE_SCHEDULER, PROFILE_STORE, PROFILE_LISTENER, PROFILE_CLOCK,
+    PROFILE_OUTPUT, PROFILE_SECTIONS
+};
+Profiler<PROFILE_SECTIONS> profiler;
 
 /**
- * Levels:
- *  - no logs 0
- *  - error 1
- *  - warn 2
- *  - info 3
- *  - debug
+ * Time of day packed as milliseconds since midnight.
+ *
+ * The wall clock advances by adding millis() deltas and wrapping at midnight, so `now` costs no
+ * division; hours, minutes and seconds are only split out when the time gets formatted. It also
+ * counts the day of the week (0 is Monday), which moves on at every midnight and is Monday until
+ * set; schedules that run on some weekdays only take times as ms since Monday 00:00.
+ *
+ * Two corrections ride on the deltas, both in integer arithmetic. The rate makes up for a crystal
+ * running fast or slow: ms per ms in Q0.24 (1 ppm is about 16.8), its fraction carried from one
+ * call to the next. A slew works an offset in at 1 ms per 2^SLEW_SHIFT ms instead of jumping, so
+ * the clock never runs backwards or skips ahead past a job; only offsets beyond MAX_SLEW_MS step
+ * it, as `set` does. ClockSync sets both from a host.
  */
-struct {
-    template<class TInput>
-    static void println(const char level, const TInput arg, bool appendNewLine) {
-        Serial.print(level);
-        Serial.print("/");
-        Serial.print(millis());
-        Serial.print("/");
-        if (appendNewLine) Serial.println(arg);
-        else Serial.print(arg);
+struct Time {
+    static const uint32_t DAY_MS = 86400000;
+    static const uint32_t WEEK_MS = 7 * DAY_MS;
+
+    // Rates, their carried fraction and ClockSync's corrections are signed and scaled down with
+    // `>>`, relying on GCC's arithmetic right shift of negative values: it floors, so the fraction
+    // masked off after it stays positive and a negative rate is not rounded towards zero.
+    static const uint8_t RATE_SHIFT = 24;
+    // about 7800 ppm, beyond any resonator; a chunk of MAX_RATE_CHUNK_MS times it fits 32 bits
+    static const int32_t MAX_RATE = 1L << 17;
+    static const uint16_t MAX_RATE_CHUNK_MS = 1U << 13;
+    // 1 ms every 32 ms, about 3 %
+    static const uint8_t SLEW_SHIFT = 5;
+    static const uint32_t MAX_SLEW_MS = 60000;
+
+    uint32_t ms = 0;
+
+    constexpr Time() = default;
+    constexpr explicit Time(uint32_t msOfDay): ms{msOfDay} {}
+
+    static constexpr Time of(uint8_t hours, uint8_t minutes, uint8_t seconds = 0, uint16_t milliseconds = 0) {
+        return Time(((hours * 60UL + minutes) * 60UL + seconds) * 1000UL + milliseconds);
     }
 
-    uint8_t level = 3;
-    bool debugOn = true;
+    constexpr uint32_t toMs() const { return ms; }
+
+    uint8_t hours() const { return ms / 3600000UL; }
+    uint8_t minutes() const { return (ms / 60000UL) % 60; }
+    uint8_t seconds() const { return (ms / 1000UL) % 60; }
+    uint16_t milliseconds() const { return ms % 1000; }
+
+    constexpr bool operator==(const Time& other) const { return ms == other.ms; }
+    constexpr bool operator!=(const Time& other) const { return ms != other.ms; }
+    constexpr bool operator<(const Time& other) const { return ms < other.ms; }
+    constexpr bool operator>(const Time& other) const { return ms > other.ms; }
+    constexpr bool operator<=(const Time& other) const { return ms <= other.ms; }
+    constexpr bool operator>=(const Time& other) const { return ms >= other.ms; }
+
+    constexpr int8_t compareTo(const Time& other) const { return ms == other.ms ? 0 : (ms > other.ms ? 1 : -1); }
+
+    static Time now() { return Time{nowMs()}; }
+
+    static uint32_t nowMs() {
+        const auto currentMillis = millis();
+        auto elapsed = getMillisDiff(currentMillis, prevMillis);
+        prevMillis = currentMillis;
+        if (!elapsed) return current;
+        // neither takes more than a fraction of `elapsed`, so the sum stays positive
+        if (_rate) elapsed += rated(elapsed);
+        if (_slewLeft) elapsed += slewed(elapsed);
+        if (elapsed >= DAY_MS) {
+            _weekday = (_weekday + elapsed / DAY_MS) % 7;
+            elapsed %= DAY_MS;
+        }
 
-    template<class TInput>
-    void info(const TInput arg, bool appendNewLine = true) const {
-        if (level >= 3) println('i', arg, appendNewLine);
+        current += elapsed;
+        if (current >= DAY_MS) {
+            current -= DAY_MS;
+            _weekday = _weekday == 6 ? 0 : _weekday + 1;
+        }
+        return current;
     }
-    template<class TInput>
-    void warn(const TInput arg, bool appendNewLine = true) const {
-        if (level >= 2) println('w', arg, appendNewLine);
+
+    static uint32_t nowWeekMs() {
+        const auto ms = nowMs();
+        return _weekday * DAY_MS + ms;
     }
-    template<class TInput>
-    void error(const TInput arg, bool appendNewLine = true) const {
-        if (level >= 1) println('e', arg, appendNewLine);
+
+    static uint8_t weekday() { return _weekday; }
+
+    static Time fromMs(unsigned long long duration) {
+        return Time{(uint32_t)(duration % DAY_MS)};
     }
-    template<class TInput>
-    void debug(const TInput arg, bool appendNewLine = true) const {
-        if (debugOn) println('d', arg, appendNewLine);
+
+    static void set(const Time &time) {
+        current = time.ms;
+        prevMillis = millis();
+        _slewLeft = 0;
+        _revision++;
     }
-} logger;
 
-struct {
-    template<typename TBus>
-    bool get(TBus state, TBus stateBit) { return state & stateBit; }
-    template<typename TBus>
-    TBus set(TBus state, TBus stateBit, bool value) {
-        return (value) ? state | stateBit : state & ~stateBit;
+    // Moves the clock by `offsetMs`: slewed in when it is within MAX_SLEW_MS, stepped otherwise.
+    // True when it stepped.
+    static bool adjust(int32_t offsetMs) {
+        const auto ms = nowMs();
+        if (offsetMs >= -(int32_t)MAX_SLEW_MS && offsetMs <= (int32_t)MAX_SLEW_MS) {
+            _slewLeft = offsetMs;
+            _slewElapsed = 0;
+            return false;
+        }
+        const auto moved = (int32_t)ms + offsetMs % (int32_t)DAY_MS;
+        if (moved < 0) {
+            current = moved + DAY_MS;
+            _weekday = _weekday ? _weekday - 1 : 6;
+        } else if ((uint32_t)moved >= DAY_MS) {
+            current = moved - DAY_MS;
+            _weekday = _weekday == 6 ? 0 : _weekday + 1;
+        } else current = moved;
+        _slewLeft = 0;
+        _revision++;
+        return true;
     }
-    template<typename TBus, typename TIndex>
-    TBus indexAsBit(TIndex index) {
-        TBus result = 1;
-        for (TIndex i = 0; i < index; i++) result *= 2;
-        return result;
+
+    static void setRate(int32_t rate) {
+        _rate = rate > MAX_RATE ? MAX_RATE : rate < -MAX_RATE ? -MAX_RATE : rate;
     }
-} BitWise;
 
-// TODO: better comparison implementation
-struct Time: IEquatable<Time>, IComparable<Time> {
-    uint8_t milliseconds = 0;
-    uint8_t seconds = 0;
-    uint8_t minutes = 0;
-    uint8_t hours = 0;
+    static int32_t rate() { return _rate; }
+    // What of the last adjust is still to be slewed in.
+    static int32_t slewLeft() { return _slewLeft; }
 
-    Time& setMs(uint8_t ms) {
-        milliseconds = ms;
-        return *this;
+    static void setWeekday(uint8_t weekday) {
+        nowMs();
+        _weekday = weekday % 7;
+        _revision++;
     }
 
-    Time& setSeconds(uint8_t secs) {
-        seconds = secs;
-        return *this;
+    // Changes on every `set`, so anything derived from the wall clock can notice the jump.
+    static uint8_t revision() { return _revision; }
+
+private:
+    static uint32_t current;
+    static uint32_t prevMillis;
+    static uint8_t _revision;
+    static uint8_t _weekday;
+    static int32_t _rate;
+    static int32_t _rateFraction;
+    static int32_t _slewLeft;
+    static uint32_t _slewElapsed;
+
+    // Whole ms the rate adds to `elapsed`; the fraction below 1 ms waits for the next call.
+    static int32_t rated(uint32_t elapsed) {
+        int32_t ms = 0;
+        while (elapsed) {
+            const uint16_t chunk = elapsed > MAX_RATE_CHUNK_MS ? MAX_RATE_CHUNK_MS : elapsed;
+            elapsed -= chunk;
+            _rateFraction += (int32_t)chunk * _rate;
+            ms += _rateFraction >> RATE_SHIFT;
+            _rateFraction &= (1L << RATE_SHIFT) - 1;
+        }
+        return ms;
     }
 
-    Time& setMinutes(uint8_t mins) {
-        minutes = mins;
-        return *this;
+    // The ms of the slew due over `elapsed`, taken off what is left of it.
+    static int32_t slewed(uint32_t elapsed) {
+        const uint32_t left = _slewLeft < 0 ? -_slewLeft : _slewLeft;
+        uint32_t ms = left;
+        if (elapsed < left << SLEW_SHIFT) {
+            _slewElapsed += elapsed;
+            ms = _slewElapsed >> SLEW_SHIFT;
+            _slewElapsed &= (1U << SLEW_SHIFT) - 1;
+        }
+        if (_slewLeft < 0) {
+            _slewLeft += ms;
+            return -(int32_t)ms;
+        }
+        _slewLeft -= ms;
+        return ms;
     }
+};
+
+uint32_t Time::current = 0;
+uint32_t Time::prevMillis = 0;
+uint8_t Time::_revision = 0;
+uint8_t Time::_weekday = 0;
+int32_t Time::_rate = 0;
+int32_t Time::_rateFraction = 0;
+int32_t Time::_slewLeft = 0;
+uint32_t Time::_slewElapsed = 0;
 
-    Time& setHours(uint8_t hour) {
-        hours = hour;
-        return *this;
+/**
+ * Sets the clock from a host over the command link, in two messages.
+ *
+ * `syn` carries the host's time as it sent it (t1) and the feeder answers with its own at once
+ * (t2). `sya` carries the host's time as that answer arrived (t4): the round trip is t4 - t1, the
+ * host's time at t2 is taken to be t1 plus half of it, and the difference goes to Time::adjust,
+ * wrong by half the asymmetry of the link at most. Exchanges slower than MAX_RTT_MS are dropped.
+ *
+ * Of the offset the next exchange finds, what the slew still pending does not account for was
+ * drift: divided by the millis() between the two it is the rate still missing, added on when they
+ * are MIN_RATE_INTERVAL_MS apart or more (a quarter of it once there is a rate, so one lopsided
+ * round trip does not swing it). A step, or a `set` in between, starts the interval over.
+ */
+struct ClockSync {
+    static const uint16_t MAX_RTT_MS = 1000;
+    static const uint32_t MIN_RATE_INTERVAL_MS = 600000;
+    // the first estimate is taken whole, later ones by a quarter against the jitter of the link
+    static const uint8_t RATE_GAIN_SHIFT = 2;
+
+    struct Result {
+        uint16_t rttMs;
+        int32_t offsetMs;
+        // the offset was stepped rather than slewed in
+        bool isStepped;
+    };
+
+    // t1 in, t2 out.
+    uint32_t request(uint32_t hostSentMs) {
+        _hostSentMs = hostSentMs;
+        _deviceMs = Time::nowMs();
+        _deviceMillis = millis();
+        _slewLeft = Time::slewLeft();
+        _isPending = true;
+        return _deviceMs;
     }
 
-    uint32_t toMs() const {
-        return (hours * 3600000) + (minutes * 60000) + (seconds * 1000) + milliseconds;
+    // False when no request is open or the round trip is too slow to go by.
+    bool adjust(uint32_t hostReceivedMs, Result& result) {
+        if (!_isPending) return false;
+        _isPending = false;
+        const auto rttMs = (hostReceivedMs + Time::DAY_MS - _hostSentMs) % Time::DAY_MS;
+        if (rttMs > MAX_RTT_MS) return false;
+
+        auto offsetMs = (int32_t)((_hostSentMs + rttMs / 2 + Time::DAY_MS - _deviceMs) % Time::DAY_MS);
+        if (offsetMs > (int32_t)(Time::DAY_MS / 2)) offsetMs -= Time::DAY_MS;
+        result = Result{(uint16_t)rttMs, offsetMs, false};
+
+        const auto intervalMs = _deviceMillis - _lastMillis;
+        if (_hasBaseline && _revision == Time::revision() && intervalMs >= MIN_RATE_INTERVAL_MS) {
+            const int64_t driftMs = offsetMs - _slewLeft;
+            const auto missing = (int32_t)(driftMs * ((int64_t)1 << Time::RATE_SHIFT) / (int64_t)intervalMs);
+            Time::setRate(Time::rate() + (_hasRate ? missing >> RATE_GAIN_SHIFT : missing));
+            _hasRate = true;
+        }
+        result.isStepped = Time::adjust(offsetMs);
+        _lastMillis = _deviceMillis;
+        _revision = Time::revision();
+        _hasBaseline = true;
+        return true;
     }
 
-    bool equals(const Time* other) const override {
-        if (other == nullptr) return false;
-        return hours == other->hours
-               && minutes == other->minutes
-               && seconds == other->seconds
-               && milliseconds == other->milliseconds;
+    // Time's rate in hundredths of a ppm, positive when the clock is sped up.
+    static int32_t ratePpm100() { return (int32_t)((int64_t)Time::rate() * 100000000 >> Time::RATE_SHIFT); }
+
+private:
+    uint32_t _hostSentMs = 0;
+    uint32_t _deviceMs = 0;
+    uint32_t _deviceMillis = 0;
+    int32_t _slewLeft = 0;
+    uint32_t _lastMillis = 0;
+    uint8_t _revision = 0;
+    bool _isPending = false;
+    bool _hasBaseline = false;
+    bool _hasRate = false;
+};
+
+/**
+ * The parts of the program Program::act() runs every pass. A component is any type with
+ * `void react()`, `Wake nextWake() const` (how long react() can be skipped and which inputs must
+ * be able to cut that short; see Sleep.h) and three constants:
+ *  - SECTION: the ProfileSection it is timed under, which is also its place in the pass
+ *  - WAKE_SOURCES: every source its nextWake() can ask for; anything else is masked off
+ *  - PERIOD_MS: the fixed period it wants passes at while busy, Wake::NEVER if it only waits for
+ *    inputs and deadlines
+ *
+ * ComponentList holds them as pointers to members of their owner and calls them by their own type,
+ * so nothing is virtual: act() and idle() come out as one unrolled, inlined sequence, and no
+ * component carries a vtable pointer. The list must follow section order, checked at compile time.
+ */
+template<typename T> struct MemberPointer;
+template<typename TOwner, typename T> struct MemberPointer<T TOwner::*> { typedef T Type; };
+
+template<uint8_t COUNT> constexpr uint32_t shortestPeriod(const uint32_t (&periods)[COUNT]) {
+    uint32_t periodMs = Wake::NEVER;
+    for (const auto value : periods) if (value < periodMs) periodMs = value;
+    return periodMs;
+}
+
+template<uint8_t COUNT> constexpr bool isInSectionOrder(const ProfileSection (&sections)[COUNT]) {
+    for (uint8_t i = 0; i < COUNT; ++i) {
+        if (sections[i] <= PROFILE_ACT || sections[i] >= PROFILE_SECTIONS) return false;
+        if (i && sections[i] <= sections[i - 1]) return false;
     }
+    return true;
+}
+
+template<auto... COMPONENTS>
+struct ComponentList {
+    template<auto COMPONENT> using TypeOf = typename MemberPointer<decltype(COMPONENT)>::Type;
+
+    static constexpr uint8_t COUNT = sizeof...(COMPONENTS);
+    static constexpr uint8_t WAKE_SOURCES = (0 | ... | TypeOf<COMPONENTS>::WAKE_SOURCES);
+    static constexpr uint32_t PERIOD_MS = shortestPeriod<COUNT>({TypeOf<COMPONENTS>::PERIOD_MS...});
 
-    int8_t compareTo(const Time* other) const override {
-        if (other == nullptr) return 1;
-        if (equals(other)) return 0;
+    static_assert(isInSectionOrder<COUNT>({TypeOf<COMPONENTS>::SECTION...}),
+                  "components must be listed in ProfileSection order, each in a section of its own");
 
-        return (hours > other->hours
-                 || (hours == other->hours && minutes > other->minutes)
-                 || (hours == other->hours && minutes == other->minutes && seconds > other->seconds)
-                 || (hours == other->hours && minutes == other->minutes && seconds == other->seconds && milliseconds > other->milliseconds))
-                 ? 1 : -1;
+    template<typename TOwner> static void react(TOwner& owner) {
+        (profiler.measure(TypeOf<COMPONENTS>::SECTION, [&owner] { (owner.*COMPONENTS).react(); }), ...);
     }
 
-    bool isBetween(const Time& lowerBound, const Time& upperBound) const {
-        const auto lowerBoundResult = lowerBound.compareTo(this);
-        const auto upperBoundResult = upperBound.compareTo(this);
-        return (lowerBoundResult >= 0) && (upperBoundResult >= 0);
+    template<typename TOwner> static Wake nextWake(const TOwner& owner) {
+        Wake wake{Wake::NEVER};
+        ((wake = wake.earliest(masked<TypeOf<COMPONENTS>::WAKE_SOURCES>((owner.*COMPONENTS).nextWake()))), ...);
+        return wake;
     }
 
-    static Time now() {
-        auto currentMillis = millis();
-        timeElapsed += getMillisDiff(currentMillis, prevMillis);
-        prevMillis = currentMillis;
-        return Time::fromMs(Time::started.toMs() + timeElapsed);
+private:
+    template<uint8_t SOURCES> static constexpr Wake masked(const Wake& wake) {
+        return Wake{wake.inMs, (uint8_t)(wake.sources & SOURCES)};
     }
+};
 
-    static Time fromMs(unsigned long long duration) {
-        Time time = {};
-        time.milliseconds = (duration % 1000) / 100;
-        time.seconds = (duration / 1000) % 60;
-        time.minutes = (duration / 60000) % 60;
-        time.hours = (duration / 3600000) % 24;
-        return time;
+/**
+ * Props and state are updated in place, nothing is copied. Each field a component cares about has
+ * a bit of its own (props and state share one mask); `set` writes a field and marks its bit only
+ * when the value really changes, `touch` marks a bit for changes that are not a plain comparison.
+ *
+ * `react` lets `updateProps` refresh the props, then calls `componentDidUpdate` with the bits
+ * marked since the previous call for as long as something is marked, at most MAX_RENDERS times.
+ * Whatever is still marked then is handled on the next tick (and keeps `isDirty` true until it is).
+ */
+template<typename TDerived, typename TProps, typename TState, uint8_t MAX_RENDERS = 4>
+struct Component {
+    typedef uint8_t Changes;
+
+    TProps props{};
+    TState state{};
+
+    // TDerived provides `updateProps()` and `componentDidUpdate(Changes)`.
+    void react() {
+        auto& self = static_cast<TDerived&>(*this);
+        self.updateProps();
+        for (uint8_t i = 0; _dirty && i < MAX_RENDERS; ++i) {
+            const auto changes = _dirty;
+            _dirty = 0;
+            self.componentDidUpdate(changes);
+        }
     }
 
-    static void set(const Time &time) {
-        started = time;
+    Wake nextWake() const { return Wake{_dirty ? 0 : Wake::NEVER}; }
+
+protected:
+    template<typename T> void set(T& field, const T& value, Changes bit) {
+        if (field == value) return;
+        field = value;
+        _dirty |= bit;
     }
+    void touch(Changes bit) { _dirty |= bit; }
+    bool isDirty() const { return _dirty; }
 
 private:
-    static Time started;
-    static uint32_t prevMillis;
-    static uint32_t timeElapsed;
+    Changes _dirty = 0;
 };
 
-Time Time::started;
-uint32_t Time::prevMillis = 0;
-uint32_t Time::timeElapsed = 0;
+/**
+ * When a job comes round again, packed in 32 bits: the weekdays it runs on (bit 0 is Monday) and,
+ * optionally, every `intervalMin` minutes after its time of day, up to `endMin` minutes after
+ * midnight. "Weekdays between 07:00 and 19:00 every 90 minutes" is one job at 07:00 with
+ * {0b0011111, 90, 19 * 60}; the default runs once a day, every day.
+ *
+ * The next occurrence after any time of the week is computed directly, without walking through
+ * the ones in between: a division for the rest of the day, at most a week of weekday bits after.
+ */
+struct Recurrence {
+    static const uint8_t EVERY_DAY = 0x7F;
+    static const uint16_t MAX_MINUTE = 24 * 60 - 1;
+    static const uint32_t NEVER = 0xFFFFFFFF;
 
-struct IReact { virtual void react() = 0; };
+    uint32_t weekdays: 7;
+    uint32_t intervalMin: 11;
+    uint32_t endMin: 11;
 
-// TODO: transform to functional component (react function, accepting transformer functions and a (static) object reference)
-template<typename TProps, typename TState>
-struct Component: IReact {
-    TProps props;
-    TState state;
+    constexpr Recurrence(uint8_t weekdays = EVERY_DAY, uint16_t intervalMin = 0, uint16_t endMin = 0):
+            weekdays{weekdays}, intervalMin{intervalMin}, endMin{endMin} {}
 
-    Component(): props{}, state{} {}
+    constexpr bool isValid() const { return weekdays && intervalMin <= MAX_MINUTE && endMin <= MAX_MINUTE; }
+    constexpr bool isDaily() const { return weekdays == EVERY_DAY && !intervalMin; }
 
-    virtual void componentDidUpdate(const TProps& prevProps, const TState& prevState, TState& nextState, bool& shouldUpdate) = 0;
-    virtual void updateProps(TProps& nextProps, bool& shouldUpdate) = 0;
+    constexpr bool operator==(const Recurrence& other) const {
+        return weekdays == other.weekdays && intervalMin == other.intervalMin && endMin == other.endMin;
+    }
 
-    void react() override {
-        bool shouldUpdate = false;
-        auto prevProps = props;
-        updateProps(props, shouldUpdate);
-        auto nextState = state;
-        while (shouldUpdate) {
-            shouldUpdate = false;
-            auto prevState = state;
-            state = nextState;
-            componentDidUpdate(prevProps, prevState, nextState, shouldUpdate);
-            prevProps = props;
+    constexpr uint32_t pack() const { return weekdays | (uint32_t)intervalMin << 7 | (uint32_t)endMin << 18; }
+    static constexpr Recurrence unpack(uint32_t value) {
+        return Recurrence{(uint8_t)(value & 0x7F), (uint16_t)(value >> 7 & 0x7FF), (uint16_t)(value >> 18 & 0x7FF)};
+    }
+
+    // ms from `fromWeekMs` (ms since Monday 00:00) to the first occurrence after it, up to a
+    // week for a job that runs once a week; NEVER without any weekday.
+    uint32_t msAfter(const Time& start, uint32_t fromWeekMs) const {
+        const uint8_t weekday = fromWeekMs / Time::DAY_MS;
+        const uint32_t fromMs = fromWeekMs % Time::DAY_MS;
+
+        if (weekdays >> weekday & 1) {
+            const auto atMs = laterThan(start.toMs(), fromMs);
+            if (atMs != NEVER) return atMs - fromMs;
         }
+        for (uint8_t days = 1; days <= 7; ++days) {
+            if (weekdays >> (weekday + days) % 7 & 1) return days * Time::DAY_MS - fromMs + start.toMs();
+        }
+        return NEVER;
+    }
+
+private:
+    // The first occurrence of a day after `fromMs`, NEVER if that day has no more.
+    uint32_t laterThan(uint32_t startMs, uint32_t fromMs) const {
+        if (fromMs < startMs) return startMs;
+        if (!intervalMin) return NEVER;
+
+        const auto intervalMs = intervalMin * 60000UL;
+        const auto atMs = startMs + ((fromMs - startMs) / intervalMs + 1) * intervalMs;
+        return atMs <= endMin * 60000UL && atMs < Time::DAY_MS ? atMs : NEVER;
     }
 };
 
-template<typename TContext> struct DayJob: IEquatable<DayJob<TContext>> {
+template<typename TContext> struct DayJob {
     const bool isSystem;
     const Time time;
-    void(*task)(TContext&);
-    explicit DayJob(const Time time, void(*task)(TContext&), bool isSystem = false): isSystem{isSystem}, time{time}, task{task} {}
+    // the scheduler's to change, while the job is not scheduled
+    Recurrence rule;
+    void(*task)(TContext&, const DayJob<TContext>&);
+    // the scheduler's: its version of the schedule when the job was last scheduled
+    uint16_t version = 0;
+    explicit DayJob(const Time time, void(*task)(TContext&, const DayJob<TContext>&), bool isSystem = false, Recurrence rule = {}):
+            isSystem{isSystem}, time{time}, rule{rule}, task{task} {}
     ~DayJob() = default;
 
-    bool equals(const DayJob<TContext>* other) const override { return time.equals(&other->time); }
+    // Jobs by time of day; those at the same time by rule, and no two alike.
+    struct Order {
+        static bool less(const DayJob* a, const DayJob* b) {
+            return a->time < b->time || (a->time == b->time && a->rule.pack() < b->rule.pack());
+        }
+    };
 };
 
-template<typename TItem, uint8_t SIZE> struct StaticArray {
-    TItem list[SIZE]{};
-    uint8_t count = 0;
-    uint8_t size = SIZE;
+// BITS flags in as few bytes as hold them.
+template<uint8_t BITS> struct Bitset {
+    bool test(uint8_t index) const { return _bytes[index >> 3] >> (index & 7) & 1; }
+    void set(uint8_t index) { _bytes[index >> 3] |= 1 << (index & 7); }
+    void clear() { memset(_bytes, 0, sizeof(_bytes)); }
 
-    virtual bool add(TItem item) {
-        if (count == SIZE) return false;
-
-        list[count++] = item;
-        return true;
+    bool any() const {
+        for (const auto value : _bytes) if (value) return true;
+        return false;
     }
 
-    const TItem* at(int16_t index) const {
-        if (index < 0 || index >= count) return nullptr;
+private:
+    uint8_t _bytes[(BITS + 7) / 8]{};
+};
+
+/**
+ * Only the next deadline is watched, so an idle `react` is a single millis() comparison whatever the
+ * number of jobs. Arming asks every job's rule for its next occurrence, in constant time each, and
+ * keeps the earliest along with a bit per job due then. Jobs are kept ordered by their time of
+ * day, which is the order they run in when due together and the one they are listed in.
+ *
+ * When the deadline passes, the jobs due then run, then those of every later deadline up to now,
+ * in order. Occurrences missed by more than CATCH_UP_WINDOW_MS (the loop stalled for that long) are
+ * skipped instead of run late. A clock change through `Time::set` or `Time::setWeekday` re-anchors
+ * the schedule at the new time without running the jobs that were jumped over, forwards or
+ * backwards. Midnight is waited for as well, when the jobs' done-today flags change.
+ *
+ * Deadlines are waited for in millis(), which drifts from the clock by its rate and slew. The wait
+ * is scaled by the rate, and a wait that ends before the clock reaches the deadline is armed again
+ * for the rest. No wait is longer than MAX_WAIT_MS, so a slew or a rate change made in the meantime
+ * cannot make a far deadline fire late.
+ */
+template<typename TContext, uint8_t CAPACITY = 10> struct DayJobsScheduler {
+    static const uint8_t MAX_JOBS = CAPACITY;
+    static const uint32_t CATCH_UP_WINDOW_MS = 15UL * 60 * 1000;
+    // millis() runs apart from the clock by its rate, so a deadline is not waited for longer at once
+    static const uint32_t MAX_WAIT_MS = 60UL * 60 * 1000;
+    static constexpr LogLevel LOG_MODULE_LEVEL = LOG_LEVEL_SCHEDULER;
+    static constexpr ProfileSection SECTION = PROFILE_SCHEDULER;
+    static constexpr uint8_t WAKE_SOURCES = 0;
+    static constexpr uint32_t PERIOD_MS = Wake::NEVER;
+
+    explicit DayJobsScheduler(TContext& context): _context(context) {}
+
+    void react() {
+        if (_clockRevision == Time::revision() && !isDue()) return;
 
-        return &(list[index]);
+        const auto nowMs = Time::nowWeekMs();
+        const bool isClockSet = _clockRevision != Time::revision();
+        if (!isClockSet) runDue(nowMs);
+        // every job's done-today flag may have changed with the day or the clock
+        if (isClockSet || nowMs / Time::DAY_MS != _day) touchAll();
+        _clockRevision = Time::revision();
+        arm(nowMs);
     }
 
-    bool set(int16_t index, TItem item) {
-        if (index < 0 || index >= count) return false;
-        list[index] = item;
+    bool schedule(DayJob<TContext>* job) {
+        if (!job->rule.isValid() || !_jobs.add(job)) return false;
+
+        job->version = ++_version;
+        rearm();
         return true;
     }
-};
 
-template<typename TItem, unsigned short SIZE> struct Array {
-    TItem* list[SIZE]{};
-    unsigned short count = 0;
-    const unsigned short size = SIZE;
+    bool unschedule(DayJob<TContext>* job) {
+        if (!_jobs.removeAt(indexOf(job))) return false;
+
+        _removedAt = ++_version;
+        rearm();
+        return true;
+    }
 
-    Array() = default;
-    Array(unsigned short count, TItem* items...): list{items}, count{count} {}
-    explicit Array(TItem* init[SIZE]): list{init} { for (int i = 0; i < SIZE && init[i]; ++i) count = i; }
+    // Gives a scheduled job another rule; false, with the old one kept, if that makes it the
+    // same as another job or the rule is not valid.
+    bool reschedule(DayJob<TContext>* job, const Recurrence& rule) {
+        if (!rule.isValid() || indexOf(job) == _jobs.size()) return false;
+
+        // the job stays in the table as far as exports are concerned: changed, not removed
+        const auto previous = job->rule;
+        const auto removedAt = _removedAt;
+        unschedule(job);
+        _removedAt = removedAt;
+        job->rule = rule;
+        if (schedule(job)) return true;
+
+        job->rule = previous;
+        schedule(job);
+        return false;
+    }
 
-    virtual bool add(TItem *item) {
-        if (count == SIZE) return false;
+    Wake nextWake() const {
+        if (_clockRevision != Time::revision()) return Wake{};
 
-        list[count++] = item;
-        return true;
+        const auto elapsedMs = getMillisDiff(millis(), _armedAt);
+        return Wake{(uint32_t)(elapsedMs >= _waitMs ? 0 : _waitMs - elapsedMs)};
     }
 
-    bool removeAt(int index) {
-        if (!count || index < 0 || index >= count) return false;
-        for (unsigned short i = index; i < count; ++i) {
-            list[i] = at(i + 1);
-        }
-        count--;
-        return true;
+    typedef SortedSet<DayJob<TContext>*, CAPACITY, typename DayJob<TContext>::Order> Jobs;
+
+    const Jobs& getJobs() const { return _jobs; }
+
+    // Takes a whole new table, no two jobs in it alike, in place of the current one.
+    void replace(const Jobs& jobs) {
+        _jobs = jobs;
+        touchAll();
+        _removedAt = _version;
+        rearm();
     }
 
-    TItem* at(int index) const {
-        if (index < 0 || index >= count) return nullptr;
+    // Moves on with every change to the table, from 0 at boot, and with every change to what the
+    // jobs' occurrences left today are (a job's last one today run, the day over, the clock set);
+    // removals are remembered by the last version one happened at, so exports can tell what changed
+    // since a version (see StateExport).
+    uint16_t version() const { return _version; }
+    uint16_t removedAt() const { return _removedAt; }
 
-        return list[index];
+private:
+    TContext& _context;
+    Jobs _jobs;
+    // the jobs, by index in _jobs, with an occurrence at _dueMs; redone before they run
+    Bitset<CAPACITY> _due;
+
+    // ms since Monday 00:00: the deadline, and the time it was armed at
+    uint32_t _dueMs = 0;
+    uint32_t _fromMs = 0;
+    uint32_t _armedAt = 0;
+    uint32_t _waitMs = 0;
+    uint8_t _clockRevision = Time::revision() - 1;
+    uint16_t _version = 0;
+    uint16_t _removedAt = 0;
+    // of the week, when last armed
+    uint8_t _day = 0xFF;
+
+    bool isDue() const { return getMillisDiff(millis(), _armedAt) >= _waitMs; }
+
+    // Where `job` itself is scheduled, not another one alike; _jobs.size() if it is not.
+    uint8_t indexOf(DayJob<TContext>* job) const {
+        const auto index = _jobs.indexOf(job);
+        return index < _jobs.size() && _jobs[index] == job ? index : _jobs.size();
     }
 
-    bool set(int index, TItem* item) {
-        if (index < 0 || index >= count) return false;
-        list[index] = item;
-        return true;
+    // ms from `fromMs` forward to `toMs` in the week, across its end if needed
+    static uint32_t msUntil(uint32_t fromMs, uint32_t toMs) {
+        return toMs >= fromMs ? toMs - fromMs : Time::WEEK_MS - fromMs + toMs;
     }
 
-    long indexOf(const IEquatable<TItem>* item) {
-        for (unsigned short i = 0; i < count; ++i) {
-            const auto currentItem = list[i];
-            if (item->equals(currentItem)) return i;
+    // Moves the deadline to the earliest occurrence of any job after `fromMs`, and marks the jobs
+    // due then; returns how far after `fromMs` that is, Recurrence::NEVER without jobs.
+    uint32_t select(uint32_t fromMs) {
+        auto earliestMs = Recurrence::NEVER;
+        _due.clear();
+        for (uint8_t i = 0; i < _jobs.size(); ++i) {
+            const auto job = _jobs[i];
+            const auto inMs = job->rule.msAfter(job->time, fromMs);
+            if (inMs > earliestMs) continue;
+            if (inMs < earliestMs) _due.clear();
+            earliestMs = inMs;
+            _due.set(i);
         }
-        return -1;
+        _dueMs = earliestMs == Recurrence::NEVER ? fromMs : (fromMs + earliestMs) % Time::WEEK_MS;
+        return earliestMs;
     }
 
-    TItem* find(IEquatable<TItem>* item) {
-        for (unsigned int i = 0; i < count; ++i) {
-            const auto current = list[i];
-            if (item->equals(current)) return current;
+    void runDue(uint32_t nowMs) {
+        // millis() got there before the corrected clock did, or the wait was cut short: wait out the rest
+        if (msUntil(_fromMs, nowMs) < msUntil(_fromMs, _dueMs)) return;
+
+        // jobs may have come and gone since the deadline was armed
+        const auto fromMs = (_dueMs + Time::WEEK_MS - 1) % Time::WEEK_MS;
+        auto inMs = select(fromMs);
+        auto lateMs = msUntil(fromMs, nowMs);
+        if (inMs == Recurrence::NEVER || inMs > lateMs) return;
+        lateMs -= inMs;
+
+        if (lateMs > CATCH_UP_WINDOW_MS) {
+            LOG_WARN("jobs at {t} skipped, {} ms late", _dueMs % Time::DAY_MS, lateMs);
+            // what is still within the window runs
+            inMs = select((nowMs + Time::WEEK_MS - CATCH_UP_WINDOW_MS) % Time::WEEK_MS);
+            if (inMs == Recurrence::NEVER || inMs > CATCH_UP_WINDOW_MS) return;
+            lateMs = CATCH_UP_WINDOW_MS - inMs;
+        }
+
+        while (true) {
+            for (uint8_t i = 0; i < _jobs.size(); ++i) {
+                if (!_due.test(i)) continue;
+                const auto job = _jobs[i];
+                LOG_DEBUG("job at {t}", job->time.toMs());
+                job->task(_context, *job);
+                if (job->rule.msAfter(job->time, _dueMs) >= Time::DAY_MS - _dueMs % Time::DAY_MS) job->version = ++_version;
+            }
+
+            inMs = select(_dueMs);
+            if (inMs == Recurrence::NEVER || inMs > lateMs) return;
+            lateMs -= inMs;
         }
+    }
+
+    // Waits for the deadline, or for midnight if that comes first, when the done-today flags change;
+    // MAX_WAIT_MS at most, then it looks again.
+    void arm(uint32_t nowMs) {
+        _armedAt = millis();
+        _fromMs = nowMs;
+        _day = nowMs / Time::DAY_MS;
+        const auto inMs = select(nowMs);
+        const auto toMidnightMs = Time::DAY_MS - nowMs % Time::DAY_MS;
+        _waitMs = inMs < toMidnightMs ? inMs : toMidnightMs;
+        if (_waitMs > MAX_WAIT_MS) _waitMs = MAX_WAIT_MS;
+        // in millis(), which the rate runs the clock faster or slower than
+        _waitMs -= (int32_t)((int64_t)_waitMs * Time::rate() / ((int64_t)1 << Time::RATE_SHIFT));
+    }
 
-        return nullptr;
+    void touchAll() {
+        ++_version;
+        for (const auto job : _jobs) job->version = _version;
     }
 
-    TItem* begin(){return list[0];}
-    TItem* end(){return begin() + count;}
+    // A deadline that has already passed is left for `react` to run; otherwise look again from now.
+    void rearm() {
+        if (_clockRevision == Time::revision() && !isDue()) arm(Time::nowWeekMs());
+    }
 };
 
-template<typename TItem, unsigned int size> struct Set: Array<TItem, size> {
-    bool add(TItem *item) override {
-        if (Array<TItem, size>::count == size) return false;
-        if (Array<TItem, size>::find(item)) return false;
+// What a job does with the servo: `repeats` times open to `angle`, wait `dwellMs`, close again.
+struct DispenseProfile {
+    static const uint8_t MAX_ANGLE = 180;
+    static const uint8_t MAX_REPEATS = 10;
+
+    uint8_t angle;
+    uint8_t repeats;
+    uint16_t dwellMs;
 
-        return Array<TItem, size>::add(item);
+    constexpr bool isValid() const { return angle && angle <= MAX_ANGLE && repeats && repeats <= MAX_REPEATS; }
+
+    constexpr uint32_t pack() const { return (uint32_t)dwellMs << 16 | (uint16_t)repeats << 8 | angle; }
+    static constexpr DispenseProfile unpack(uint32_t value) {
+        return DispenseProfile{(uint8_t)value, (uint8_t)(value >> 8), (uint16_t)(value >> 16)};
     }
 };
 
-template<typename TContext> struct DayJobsScheduler: IReact {
-    static const unsigned char MAX_JOBS = 10;
+/**
+ * The user jobs and the wall clock, kept in EEPROM (see RecordLog.h) so that a reset does not
+ * lose the schedule. Key 0 holds the clock, key 1 + slot the user job in that pool slot: the
+ * slot's generation as the tag and the job's time of day, or EMPTY once it is gone (the tag is
+ * then the generation the slot hands out next, so ids from before the reset stay stale).
+ * The job's dispense profile follows under PROFILES + slot and its recurrence under RULES + slot,
+ * tagged with the same generation; one with any other tag belonged to an earlier job in the slot
+ * and is ignored. A job that runs once a day, every day, needs no recurrence record. There are
+ * CAPACITY slots, as many as the pool and the scheduler hold.
+ *
+ * Nothing but the records that changed is written. The clock has no battery behind it: it is
+ * saved, with the weekday as its tag, on `sti`, `swd`, a `sya` that steps it and every
+ * CLOCK_CHECKPOINT_MS, and after a reset resumes from the last save, which is closer than midnight
+ * until the host sets it again. Key RATE holds the clock's rate, saved on every `sya`.
+ */
+template<typename TContext, uint8_t CAPACITY> struct ScheduleStore {
+    static const uint32_t CLOCK_CHECKPOINT_MS = 10UL * 60 * 1000;
+    static constexpr ProfileSection SECTION = PROFILE_STORE;
+    static constexpr uint8_t WAKE_SOURCES = 0;
+    static constexpr uint32_t PERIOD_MS = CLOCK_CHECKPOINT_MS;
+    static const uint32_t EMPTY = 0xFFFFFFFF;
+
+    explicit ScheduleStore(TContext& context): _context(context) {}
+
+    // Re-creates and schedules the saved jobs and sets the clock; reads the whole log once.
+    void restore() {
+        _log.restore();
+
+        uint8_t tag;
+        uint32_t value;
+        if (_log.read(CLOCK, tag, value) && value < Time::DAY_MS) {
+            Time::set(Time(value));
+            Time::setWeekday(tag);
+        }
+        if (_log.read(RATE, tag, value)) Time::setRate((int32_t)value);
+        _checkpointAt = millis();
 
-    explicit DayJobsScheduler(TContext& context): _context(context) {}
+        auto& jobs = _context.userJobs;
+        for (uint8_t slot = 0; slot < jobs.capacity(); ++slot) {
+            if (!_log.read(JOBS + slot, tag, value)) continue;
 
-    void react() override {
-        const auto timeNow = Time::now();
-        const auto oneMinuteAfterTimeNow = Time::fromMs(timeNow.toMs() + 60000);
+            const auto handle = (uint16_t)tag << 8 | slot;
+            if (value >= Time::DAY_MS) {
+                jobs.skipTo(handle);
+                continue;
+            }
+            uint32_t rule;
+            uint8_t ruleTag;
+            const auto hasRule = _log.read(RULES + slot, ruleTag, rule) && ruleTag == tag;
+            if (!jobs.createAt(handle, Time(value), TContext::feed, false, hasRule ? Recurrence::unpack(rule) : Recurrence{})) continue;
+            if (!_context.jobsScheduler.schedule(jobs.get(handle))) {
+                jobs.destroy(handle);
+                continue;
+            }
 
-        for (unsigned int i = 0; i < _jobs.count; ++i) {
-            const auto job = _jobs.at(i);
-            const auto stateBit = BitWise.indexAsBit<uint32_t>(i);
-            const auto isDone = BitWise.get(_checkList, stateBit);
-            const auto isTimeForDoingTheJob = job->time.isBetween(timeNow, oneMinuteAfterTimeNow);
-            if (isTimeForDoingTheJob && !isDone) {
-                    job->task(_context);
-                    _checkList = BitWise.set(_checkList, stateBit, true);
-            } else if (!isTimeForDoingTheJob && isDone) _checkList = BitWise.set(_checkList, stateBit, false);
+            uint8_t profileTag;
+            const auto hasProfile = _log.read(PROFILES + slot, profileTag, value) && profileTag == tag;
+            const auto profile = DispenseProfile::unpack(value);
+            _context.jobProfiles[slot] = hasProfile && profile.isValid() ? profile : TContext::DEFAULT_PROFILE;
         }
     }
 
-    bool schedule(DayJob<TContext>* job) {
-        return _jobs.add(job);
+    // Saves the job slot behind `handle`, whether it holds a job or was just freed.
+    void saveJob(uint16_t handle) {
+        const uint8_t slot = handle & 0xFF;
+        const auto& jobs = _context.userJobs;
+        const auto current = jobs.handleAt(slot);
+        const auto job = jobs.get(current);
+        _log.write(JOBS + slot, current >> 8, job ? job->time.toMs() : EMPTY);
+        if (job) _log.write(PROFILES + slot, current >> 8, _context.jobProfiles[slot].pack());
+        if (job && !job->rule.isDaily()) _log.write(RULES + slot, current >> 8, job->rule.pack());
     }
 
-    bool unschedule(DayJob<TContext>* job) {
-        const auto index = _jobs.indexOf(job);
-        return unschedule(index);
-    }
-    bool unschedule(int index) {
-        const auto prevCount = _jobs.count;
-        if (!_jobs.removeAt(index)) return false;
-
-        for (auto i = index; i < prevCount; ++i)
-            _checkList = BitWise.set(
-                    _checkList,
-                    BitWise.indexAsBit<uint32_t>(i),
-                    ((i + 1) < prevCount) && BitWise.get(_checkList, BitWise.indexAsBit<uint32_t>(i + 1)
-                    ));
-        return true;
+    void saveClock() {
+        const auto nowMs = Time::nowMs();
+        _log.write(CLOCK, Time::weekday(), nowMs);
+        _checkpointAt = millis();
     }
-    bool unscheduleAndFree(int index) {
-        const auto isUnscheduled = unschedule(index);
-        if (!isUnscheduled) return false;
 
-        const auto job = _jobs.at(index);
-        delete job; // inspect this Clang warning
+    // The rate ClockSync has learned for the crystal, which outlives a reset.
+    void saveRate() { _log.write(RATE, 0, (uint32_t)Time::rate()); }
 
-        return true;
+    void react() {
+        if (getMillisDiff(millis(), _checkpointAt) >= CLOCK_CHECKPOINT_MS) saveClock();
+    }
+
+    Wake nextWake() const {
+        const auto elapsedMs = getMillisDiff(millis(), _checkpointAt);
+        return Wake{(uint32_t)(elapsedMs >= CLOCK_CHECKPOINT_MS ? 0 : CLOCK_CHECKPOINT_MS - elapsedMs)};
     }
 
-    const Set<DayJob<TContext>, MAX_JOBS>& getJobs() const { return _jobs; }
+    uint32_t recordsWritten() const { return _log.written; }
+    uint32_t recordsMoved() const { return _log.moved; }
 
 private:
+    static const uint8_t CLOCK = 0;
+    static const uint8_t JOBS = 1;
+    static const uint8_t PROFILES = JOBS + CAPACITY;
+    static const uint8_t RULES = PROFILES + CAPACITY;
+    static const uint8_t RATE = RULES + CAPACITY;
+
     TContext& _context;
-    uint32_t _checkList = 0b0;
-    Set<DayJob<TContext>, MAX_JOBS> _jobs;
+    RecordLog<0, 1024, RATE + 1> _log;
+    uint32_t _checkpointAt = 0;
+};
+
+/**
+ * A whole schedule of user jobs uploaded as one transaction: `begin`, a `stage` per job, `commit`
+ * with the number of jobs staged. Each job is checked as it comes (time, rule, profile, room, no
+ * two alike) into a table of its own, kept in the order the scheduler runs them; the live schedule
+ * is not touched until the commit, which checks the rest (room next to the system jobs, none alike
+ * one of them) before changing anything. It then replaces every user job with the staged ones and
+ * hands the scheduler its new table in one go, so no pass ever sees half of the old schedule and
+ * half of the new. A job that fails its check, a count that does not match or a `begin` in
+ * between leaves the schedule as it was.
+ *
+ * checksum() is a CRC-16 of the user jobs in schedule order, each as u32 ms of day, u32 packed
+ * rule and u32 packed profile, little endian: the host computes the same from what it sent.
+ */
+template<typename TContext, uint8_t CAPACITY> struct ScheduleUpload {
+    struct Entry {
+        Time time;
+        Recurrence rule;
+        DispenseProfile profile;
+
+        // as DayJob::Order has the jobs
+        struct Order {
+            static bool less(const Entry& a, const Entry& b) {
+                return a.time < b.time || (a.time == b.time && a.rule.pack() < b.rule.pack());
+            }
+        };
+    };
+
+    void begin() {
+        _staged.clear();
+        _isOpen = true;
+        _isFailed = false;
+    }
+
+    // A rule or profile of 0 is the default one: daily, TContext::DEFAULT_PROFILE.
+    uint8_t stage(uint32_t ms, uint32_t rule, uint32_t profile) {
+        const Entry entry{
+                Time(ms),
+                rule ? Recurrence::unpack(rule) : Recurrence{},
+                profile ? DispenseProfile::unpack(profile) : TContext::DEFAULT_PROFILE
+        };
+        // bits the rule does not have make it another rule than the host meant
+        const bool isValid = ms < Time::DAY_MS && (!rule || entry.rule.pack() == rule) && entry.rule.isValid()
+                && entry.profile.isValid();
+        if (_isOpen && isValid && _staged.add(entry)) return BinaryProtocol::OK;
+
+        _isFailed = true;
+        return BinaryProtocol::REJECTED;
+    }
+
+    uint8_t commit(TContext& context, uint8_t count) {
+        const bool isComplete = _isOpen && !_isFailed && count == _staged.size();
+        _isOpen = false;
+        if (!isComplete) return BinaryProtocol::REJECTED;
+
+        auto& pool = context.userJobs;
+        auto& scheduler = context.jobsScheduler;
+        typename DayJobsScheduler<TContext, CAPACITY>::Jobs jobs;
+        for (const auto job : scheduler.getJobs()) if (job->isSystem) jobs.add(job);
+        if (jobs.size() + _staged.size() > jobs.capacity()) return BinaryProtocol::REJECTED;
+        for (const auto& entry : _staged) {
+            DayJob<TContext> probe{entry.time, TContext::feed, false, entry.rule};
+            if (jobs.contains(&probe)) return BinaryProtocol::REJECTED;
+        }
+
+        for (uint8_t slot = 0; slot < CAPACITY; ++slot) pool.destroy(pool.handleAt(slot));
+        for (const auto& entry : _staged) {
+            const auto handle = pool.create(entry.time, TContext::feed, false, entry.rule);
+            context.jobProfiles[handle & 0xFF] = entry.profile;
+            jobs.add(pool.get(handle));
+        }
+        scheduler.replace(jobs);
+        // records that did not change are not written again
+        for (uint8_t slot = 0; slot < CAPACITY; ++slot) context.store.saveJob(pool.handleAt(slot));
+        _staged.clear();
+        return BinaryProtocol::OK;
+    }
+
+    static uint16_t checksum(const TContext& context) {
+        uint16_t crc = 0xFFFF;
+        for (const auto job : context.jobsScheduler.getJobs()) {
+            if (job->isSystem) continue;
+            const uint32_t values[] = {
+                    job->time.toMs(), job->rule.pack(), context.jobProfiles[context.userJobs.handleOf(job) & 0xFF].pack()
+            };
+            for (const auto value : values) {
+                const uint8_t bytes[] = {(uint8_t)value, (uint8_t)(value >> 8), (uint8_t)(value >> 16), (uint8_t)(value >> 24)};
+                crc = BinaryProtocol::crc16(bytes, sizeof(bytes), crc);
+            }
+        }
+        return crc;
+    }
+
+    uint8_t staged() const { return _staged.size(); }
+
+private:
+    SortedSet<Entry, CAPACITY, typename Entry::Order> _staged;
+    bool _isOpen = false;
+    bool _isFailed = false;
+};
+
+/**
+ * The schedule and the feeder's state read out for hosts that poll many feeders: a fixed header
+ * and fixed-width job records, a page at a time, written straight from the scheduler's table.
+ *
+ * Header, HEADER_SIZE bytes: u16 schedule version, u8 flags (FULL: every job follows; otherwise
+ * only those changed since the version asked for), u8 jobs in the table, u8 index the next page
+ * starts at (the number of jobs after the last page), u32 ms of day, u8 weekday, u32 clock
+ * offset (ms of day minus millis(), over a day), u8 servo angle, u8 servo phase (| 0x80 attached).
+ * Record, RECORD_SIZE bytes: u16 job id (0 for a system job), u32 ms of day, u8 flags (SYSTEM,
+ * DONE_TODAY: no occurrence left today, HAS_RULE: a recurrence other than daily).
+ *
+ * Since version 0 asks for everything. A job whose DONE_TODAY flag changed (its last run today,
+ * midnight, a clock set) is in a delta too: the scheduler moves its version on for those. A delta
+ * cannot tell of removed jobs, so one asked for since before the last removal, or since a version
+ * the feeder has not reached (it was reset since), comes back FULL. Versions wrap after 65535 changes.
+ */
+template<typename TContext> struct StateExport {
+    enum Flags: uint8_t { FULL = 1 };
+    enum JobFlags: uint8_t { SYSTEM = 1, DONE_TODAY = 2, HAS_RULE = 4 };
+
+    static const uint8_t HEADER_SIZE = 16;
+    static const uint8_t RECORD_SIZE = 7;
+    static const uint8_t RECORDS_PER_PAGE = (COMMAND_RESPONSE_SIZE - 3 - BinaryProtocol::CRC_SIZE - HEADER_SIZE) / RECORD_SIZE;
+
+    // Writes the page starting at job index `first`; returns the index the next one starts at.
+    static uint8_t page(const TContext& context, uint8_t first, uint16_t since, CommandResponse& response) {
+        const auto& scheduler = context.jobsScheduler;
+        const auto& jobs = scheduler.getJobs();
+        const bool isFull = isFullSince(scheduler, since);
+        const auto next = pageEnd(jobs, first, since, isFull);
+
+        const auto nowMs = Time::nowMs();
+        const auto& servo = context.servoRotator;
+        response.u16(scheduler.version()).u8(isFull ? FULL : 0).u8(jobs.size()).u8(next)
+                .u32(nowMs).u8(Time::weekday()).u32(clockOffset(nowMs))
+                .u8(servo.angle()).u8(servo.phase() | servo.isAttached() << 7);
+
+        const auto nowWeekMs = Time::nowWeekMs();
+        for (uint8_t i = first; i < next; ++i) {
+            const auto job = jobs[i];
+            if (!isFull && !isAfter(job->version, since)) continue;
+            response.u16(context.userJobs.handleOf(job)).u32(job->time.toMs()).u8(flagsOf(*job, nowWeekMs));
+        }
+        return next;
+    }
+
+    // The same as log lines, all of the jobs.
+    static void log(const TContext& context, uint16_t since) {
+        const auto& scheduler = context.jobsScheduler;
+        const bool isFull = isFullSince(scheduler, since);
+        const auto nowMs = Time::nowMs();
+        LOG_INFO("state {}{}: {} jobs, clock {t}, offset {} ms, servo at {}", scheduler.version(), isFull ? " full" : "",
+                 scheduler.getJobs().size(), nowMs, clockOffset(nowMs), context.servoRotator.angle());
+
+        const auto nowWeekMs = Time::nowWeekMs();
+        for (const auto job : scheduler.getJobs()) {
+            if (!isFull && !isAfter(job->version, since)) continue;
+            LOG_INFO("job {} at {t}, flags {}", context.userJobs.handleOf(job), job->time.toMs(), flagsOf(*job, nowWeekMs));
+        }
+    }
+
+private:
+    // `version` came after `other`, the wrap taken into account
+    static bool isAfter(uint16_t version, uint16_t other) { return (int16_t)(version - other) > 0; }
+
+    template<typename TScheduler> static bool isFullSince(const TScheduler& scheduler, uint16_t since) {
+        return !since || isAfter(since, scheduler.version()) || isAfter(scheduler.removedAt(), since);
+    }
+
+    // Past the last job that fits the page from `first`.
+    template<typename TJobs> static uint8_t pageEnd(const TJobs& jobs, uint8_t first, uint16_t since, bool isFull) {
+        uint8_t records = 0;
+        uint8_t i = first;
+        for (; i < jobs.size(); ++i) {
+            if (!isFull && !isAfter(jobs[i]->version, since)) continue;
+            if (records++ == RECORDS_PER_PAGE) break;
+        }
+        return i;
+    }
+
+    static uint32_t clockOffset(uint32_t nowMs) { return (nowMs + Time::DAY_MS - millis() % Time::DAY_MS) % Time::DAY_MS; }
+
+    static uint8_t flagsOf(const DayJob<TContext>& job, uint32_t nowWeekMs) {
+        const auto leftTodayMs = Time::DAY_MS - nowWeekMs % Time::DAY_MS;
+        return (job.isSystem ? SYSTEM : 0) | (job.rule.msAfter(job.time, nowWeekMs) >= leftTodayMs ? DONE_TODAY : 0)
+                | (job.rule.isDaily() ? 0 : HAS_RULE);
+    }
 };
 
 struct Led {
@@ -355,81 +1025,183 @@ struct StreamListenerProps {
 
 template<uint8_t bufferSize>
 struct StreamListenerState {
-    StaticArray<char, bufferSize> buffer{};
-    bool shouldSendData = false;
+    // the line or frame being assembled, and room for the '\0' after a line
+    InlineVector<char, bufferSize + 1> buffer{};
+    bool isFrame = false;
+    // what is being assembled outgrew the buffer; the rest of it is skipped up to its end
+    bool isDiscarding = false;
 };
 
-template <typename TContext, uint8_t bufferSize = 20>
-struct StreamListener: Component<StreamListenerProps<bufferSize>, StreamListenerState<bufferSize>> {
+/**
+ * Assembles text lines ended by any of the terminating characters. When an `onFrame` listener is set,
+ * a FRAME_DELIMITER starts a binary frame instead, collected verbatim up to the next delimiter.
+ * Lines and frames longer than the buffer are dropped whole and counted, never handed over cut.
+ *
+ * Each pass drains what the stream has into a ring of receiveSize bytes with as few reads as the
+ * ring's wrap allows, then scans it: bytes other than control characters go straight to the buffer,
+ * and a lookup over the control characters tells the terminators and the delimiter; a NUL outside
+ * a frame is skipped. Up to MAX_INPUTS_PER_PASS complete lines and frames are handed over in a
+ * pass; what is left in the ring then wakes the next one. Terminating characters must be control
+ * characters (below ' ').
+ */
+template <typename TContext, uint8_t bufferSize = 20, uint8_t receiveSize = 64>
+struct StreamListener: Component<StreamListener<TContext, bufferSize, receiveSize>, StreamListenerProps<bufferSize>, StreamListenerState<bufferSize>> {
+    static constexpr LogLevel LOG_MODULE_LEVEL = LOG_LEVEL_STREAM;
+    static constexpr ProfileSection SECTION = PROFILE_LISTENER;
+    static constexpr uint8_t WAKE_SOURCES = WAKE_SERIAL;
+    static constexpr uint32_t PERIOD_MS = Wake::NEVER;
+    static const uint8_t MAX_INPUTS_PER_PASS = 8;
+
+    typedef typename StreamListener::Component::Changes Changes;
+    enum: Changes { STREAM_INPUT = 0b01 };
+
+    // Handed over since boot, and dropped for not fitting the buffer.
+    uint32_t lines = 0;
+    uint32_t frames = 0;
+    uint16_t linesTruncated = 0;
+    uint16_t framesOverflowed = 0;
+
     StreamListener(
             TContext& context,
             Stream& stream,
             void(*onInput)(const char*, TContext&),
-            const char* terminatingCharacters = "\r\n"
+            const char* terminatingCharacters = "\r\n",
+            void(*onFrame)(uint8_t*, uint8_t, TContext&) = nullptr
         ):
         _context{context},
         _stream{stream},
-        _terminatingCharacters{terminatingCharacters},
-        _onInput{onInput}
-        {}
-
-    void updateProps(StreamListenerProps<bufferSize>& nextProps, bool& shouldUpdate) override {
-        shouldUpdate = _stream.available() > 0;
-    }
-
-    void componentDidUpdate(
-            const StreamListenerProps<bufferSize>& prevProps,
-            const StreamListenerState<bufferSize>& prevState,
-            StreamListenerState<bufferSize>& nextState,
-            bool& shouldUpdate
-        ) override {
-        if (_stream.available() > 0) {
-            bool hasBeenTerminated = false;
-
-            while (_stream.available() > 0) {
-                const char currentChar = _stream.read();
-
-                auto iter = _terminatingCharacters;
-                while (*iter) if (currentChar == *(iter++)) hasBeenTerminated = true;
-                if (hasBeenTerminated) {
-                    break;
-                }
+        _onInput{onInput},
+        _onFrame{onFrame}
+        {
+            while (*terminatingCharacters) mark(_stops, *terminatingCharacters++);
+            if (_onFrame) mark(_stops, FRAME_DELIMITER);
+        }
 
-                const auto isAddSuccess = nextState.buffer.add(currentChar);
-                if (!isAddSuccess) {
-                    break;
-                }
-            }
+    void updateProps() {
+        if (!_received.isEmpty() || _stream.available() > 0) this->touch(STREAM_INPUT);
+    }
+
+    Wake nextWake() const {
+        return Wake{this->isDirty() || !_received.isEmpty() || _stream.available() > 0 ? 0 : Wake::NEVER, WAKE_SERIAL};
+    }
 
-            if (this->state.buffer.count == this->state.buffer.size || hasBeenTerminated) {
-                if (this->state.buffer.count == this->state.buffer.size) {
-                    // TODO: empty the buffer maybe? undefined behaviour?
-                    nextState.buffer.set(nextState.buffer.size - 1, '\0');
-                } else if (hasBeenTerminated) {
-                    if (! nextState.buffer.add('\0')) nextState.buffer.set(nextState.buffer.size - 1, '\0');
+    void componentDidUpdate(Changes) {
+        receive();
+
+        auto& state = this->state;
+        uint8_t inputs = 0;
+        while (inputs < MAX_INPUTS_PER_PASS && !_received.isEmpty()) {
+            typename Received::Index length;
+            const auto received = _received.span(length);
+            typename Received::Index at = 0;
+            while (at < length && inputs < MAX_INPUTS_PER_PASS) {
+                // text up to the next control character is taken in one go
+                auto end = at;
+                while (end < length && (uint8_t)received[end] >= ' ') ++end;
+                if (end > at) {
+                    take(received + at, end - at);
+                    at = end;
+                    continue;
                 }
 
-                nextState.shouldSendData = true;
+                const uint8_t value = received[at++];
+                if (state.isFrame ? value != FRAME_DELIMITER : !isIn(_stops, value)) {
+                    // a NUL in a line would end it early once handed over as a string
+                    if (state.isFrame || value) take(received + at - 1, 1);
+                } else if (value == FRAME_DELIMITER && _onFrame) inputs += frameDelimiter();
+                else inputs += terminator();
             }
-
-            shouldUpdate = true;
-        }
-
-        if (this->state.shouldSendData) {
-            nextState.shouldSendData = false;
-            onInput((const char *)(this->state.buffer.list));
-            nextState.buffer = StaticArray<char, bufferSize>{};
-            shouldUpdate = true;
+            _received.pop(at);
         }
     }
 
 private:
+    static const char FRAME_DELIMITER = BinaryProtocol::FRAME_DELIMITER;
+    typedef RingBuffer<char, receiveSize> Received;
+
     TContext& _context;
     Stream& _stream;
-    const char* _terminatingCharacters;
+    Received _received;
+    // control characters that end a line or a frame, a bit each
+    uint8_t _stops[4]{};
 
     void (*_onInput)(const char*, TContext&);
     void onInput(const char* value) { if (_onInput) _onInput(value, _context); }
+
+    void (*_onFrame)(uint8_t*, uint8_t, TContext&);
+    void onFrame(uint8_t* frame, uint8_t length) { if (_onFrame) _onFrame(frame, length, _context); }
+
+    static void mark(uint8_t (&set)[4], uint8_t value) { if (value < 32) set[value >> 3] |= 1 << (value & 7); }
+    static bool isIn(const uint8_t (&set)[4], uint8_t value) { return value < 32 && (set[value >> 3] & 1 << (value & 7)); }
+
+    // Reads what the stream has, as much as fits the ring, straight into the ring's storage: up to
+    // its end, then from its start when it wraps. available() is asked once; Stream::readBytes would
+    // ask it again, and read millis() for its timeout, on every byte.
+    void receive() {
+        int available = _stream.available();
+        while (available > 0) {
+            typename Received::Index length;
+            const auto tail = _received.tail(length);
+            if (!length) return;
+            if (length > available) length = available;
+            for (typename Received::Index i = 0; i < length; ++i) tail[i] = _stream.read();
+            if (INPUT_TRACE) {
+                const auto nowMs = millis();
+                for (typename Received::Index i = 0; i < length; ++i) inputTrace.serial(nowMs, tail[i]);
+            }
+            _received.commit(length);
+            available -= length;
+        }
+    }
+
+    void take(const char* bytes, uint8_t count) {
+        auto& state = this->state;
+        if (state.isDiscarding) return;
+        if (state.buffer.size() + count <= bufferSize) state.buffer.append(bytes, count);
+        else state.isDiscarding = true;
+    }
+
+    // Ends the line being assembled; 1 when one was handed over.
+    uint8_t terminator() {
+        auto& state = this->state;
+        const bool isHandedOver = !state.isDiscarding && !state.buffer.isEmpty();
+        if (isHandedOver) {
+            state.buffer.add('\0');
+            onInput(state.buffer.data());
+            lines++;
+        } else if (state.isDiscarding) {
+            linesTruncated++;
+            LOG_WARN("line dropped, over {} bytes", bufferSize);
+        } else return 0; // empty lines (the second half of "\r\n", a wake-up byte) are not input
+        restart(false);
+        return isHandedOver;
+    }
+
+    // Opens a frame, or closes the one being assembled; 1 when one was handed over.
+    uint8_t frameDelimiter() {
+        auto& state = this->state;
+        if (!state.isFrame || (state.buffer.isEmpty() && !state.isDiscarding)) {
+            restart(true);
+            return 0;
+        }
+        const bool isHandedOver = !state.isDiscarding;
+        if (isHandedOver) {
+            onFrame((uint8_t*)(state.buffer.data()), state.buffer.size());
+            frames++;
+        } else {
+            framesOverflowed++;
+            LOG_WARN("frame dropped");
+        }
+        restart(false);
+        return isHandedOver;
+    }
+
+    void restart(bool isFrame) {
+        auto& state = this->state;
+        state.buffer.clear();
+        state.isFrame = isFrame;
+        state.isDiscarding = false;
+    }
 };
 
 struct ButtonProps {
@@ -444,7 +1216,16 @@ struct ButtonState {
     bool shouldCheckDownStartTime = false;
 };
 
-template<typename TContext> struct Button : Component<ButtonProps, ButtonState> {
+template<typename TContext> struct Button : Component<Button<TContext>, ButtonProps, ButtonState> {
+    static constexpr LogLevel LOG_MODULE_LEVEL = LOG_LEVEL_BUTTON;
+    static constexpr ProfileSection SECTION = PROFILE_BUTTON;
+    static constexpr uint8_t WAKE_SOURCES = WAKE_PIN_CHANGE | WAKE_KEEP_CLOCKS;
+    static constexpr uint32_t PERIOD_MS = Wake::NEVER;
+
+    typedef typename Button::Component::Changes Changes;
+    using Button::Component::props;
+    using Button::Component::state;
+
     explicit Button(
             int pin,
             TContext& context,
@@ -459,73 +1240,93 @@ template<typename TContext> struct Button : Component<ButtonProps, ButtonState>
             _onRelease(onRelease)
     {
         pinMode(pin, INPUT);
+        props.isHigh = digitalRead(pin);
+        inputTrace.bootLevel(pin, props.isHigh);
+        PinEdges::watch(pin);
+        Sleep::watchPin(pin);
     }
 
-     void updateProps(ButtonProps& nextProps, bool& shouldUpdate) override {
-        const auto currentMillis = millis();
-         if (getMillisDiff(currentMillis, props.millis)) {
-             nextProps.millis = currentMillis;
-             shouldUpdate = true;
-         }
-
-         const auto currentIsHigh = digitalRead(_pin);
-         if (currentIsHigh != props.isHigh) {
-             nextProps.isHigh = currentIsHigh;
-             shouldUpdate = true;
-         }
-
-    }
-
-    void componentDidUpdate(
-            const ButtonProps &prevProps,
-            const ButtonState &prevState,
-            ButtonState &nextState,
-            bool &shouldUpdate
-        ) override {
-        if (prevProps.isHigh != props.isHigh) {
+    // Edges captured by PinEdges are taken in order, each once the time up to its stamp has been
+    // handled, so click and hold are classified on the captured times however late the loop is.
+    void react() {
+        PinEdge edge;
+        do Button::Component::react(); while (PinEdges::peek(edge) && edge.pin == _pin);
+    }
+
+    // While pressed, wake for the click and then the hold threshold with the clocks running, so the
+    // release is stamped exactly; otherwise only an edge matters.
+    Wake nextWake() const {
+        if (this->isDirty() || PinEdges::isPending()) return Wake{};
+
+        uint32_t thresholdMs = Wake::NEVER;
+        if (props.isHigh && !state.isHigh) thresholdMs = BUTTON_CLICK_DIFF_MS + 1;
+        else if (state.isHigh && !state.isBeingHeld) thresholdMs = BUTTON_HOLD_DIFF_MS + 1;
+        if (!props.isHigh) return Wake{Wake::NEVER, WAKE_PIN_CHANGE};
+        if (thresholdMs == Wake::NEVER) return Wake{Wake::NEVER, WAKE_PIN_CHANGE | WAKE_KEEP_CLOCKS};
+
+        const auto downMs = getMillisDiff(millis(), state.downStartTime);
+        return Wake{(uint32_t)(downMs >= thresholdMs ? 0 : thresholdMs - downMs), WAKE_PIN_CHANGE | WAKE_KEEP_CLOCKS};
+    }
+
+    void updateProps() {
+        PinEdge edge;
+        const auto hasEdge = PinEdges::peek(edge) && edge.pin == _pin;
+
+        // time moves up to the next edge (or now) before the level changes
+        const uint32_t atMs = hasEdge ? edge.atMs : millis();
+        if ((int32_t)(atMs - (uint32_t)props.millis) > 0) {
+            set(props.millis, (unsigned long)atMs, MILLIS);
+            return;
+        }
+        if (!hasEdge) return;
+
+        PinEdges::pop();
+        inputTrace.pin(edge.atMs, edge.pin, edge.isHigh);
+        set(props.isHigh, edge.isHigh, IS_HIGH);
+    }
+
+    void componentDidUpdate(Changes changes) {
+        if (changes & IS_HIGH) {
             if (props.isHigh) {
-                logger.debug("start down");
-                nextState.downStartTime = props.millis;
+                LOG_DEBUG("start down");
+                set(state.downStartTime, props.millis, DOWN_START);
             } else {
-                nextState.isHigh = false;
-                logger.debug("end down");
+                set(state.isHigh, false, IS_PRESSED);
+                LOG_DEBUG("end down");
             }
-
-            shouldUpdate = true;
         }
 
-        if (prevState.downStartTime != state.downStartTime) {
-            logger.info("starting to check down time");
-            nextState.shouldCheckDownStartTime = true;
-            shouldUpdate = true;
+        if (changes & DOWN_START) {
+            LOG_INFO("starting to check down time");
+            state.shouldCheckDownStartTime = true;
         }
 
-        if (state.shouldCheckDownStartTime && !state.isHigh && props.isHigh) {
-            if (getMillisDiff(props.millis, state.downStartTime) > BUTTON_CLICK_DIFF_MS) {
-                nextState.isHigh = true;
-                shouldUpdate = true;
-            }
+        const auto downMs = getMillisDiff(props.millis, state.downStartTime);
+        if (state.shouldCheckDownStartTime && !state.isHigh && props.isHigh && downMs > BUTTON_CLICK_DIFF_MS) {
+            set(state.isHigh, true, IS_PRESSED);
         }
 
-        if (state.isHigh && (getMillisDiff(props.millis, state.downStartTime) > BUTTON_HOLD_DIFF_MS) && !state.isBeingHeld) {
-            nextState.isBeingHeld = true;
-            shouldUpdate = true;
+        if (state.isHigh && downMs > BUTTON_HOLD_DIFF_MS && !state.isBeingHeld) {
+            state.isBeingHeld = true;
             onHold();
         }
 
-        if (prevState.isHigh && !state.isHigh) {
-            logger.info("button up");
-            nextState.isHigh = false;
-            nextState.isBeingHeld = false;
-            nextState.shouldCheckDownStartTime = false;
-            shouldUpdate = true;
+        if ((changes & IS_PRESSED) && !state.isHigh) {
+            LOG_INFO("button up");
+            state.isBeingHeld = false;
+            state.shouldCheckDownStartTime = false;
 
-            if (getMillisDiff(props.millis, state.downStartTime) < BUTTON_HOLD_DIFF_MS) onClick();
+            if (downMs < BUTTON_HOLD_DIFF_MS) onClick();
             else onRelease();
         }
     }
 
 private:
+    using Button::Component::set;
+
+    // props.millis, props.isHigh, state.downStartTime, state.isHigh
+    enum: Changes { MILLIS = 0b0001, IS_HIGH = 0b0010, DOWN_START = 0b0100, IS_PRESSED = 0b1000 };
+
     static const uint16_t BUTTON_HOLD_DIFF_MS = 500;
     static const uint16_t BUTTON_CLICK_DIFF_MS = 50;
 
@@ -551,230 +1352,627 @@ private:
 #pragma endregion handlers
 };
 
-struct ServoRotator: IReact {
-    explicit ServoRotator(const int pin) {
-        _servo.attach(pin);
-        _servo.write(CLOSED_DEGREES);
+/**
+ * S-curve for servo moves: the share of the way covered (0..255) at STEPS + 1 evenly spaced points
+ * in time, following smoothstep (3t² - 2t³), so the horn starts and stops without a jerk. Built
+ * while compiling; `at` interpolates between the points.
+ */
+template<uint8_t STEPS>
+struct ServoRamp {
+    uint8_t shares[STEPS + 1];
+
+    constexpr ServoRamp(): shares{} {
+        for (uint8_t i = 0; i <= STEPS; ++i) {
+            shares[i] = (uint8_t)(255UL * i * i * (3UL * STEPS - 2UL * i) / ((uint32_t)STEPS * STEPS * STEPS));
+        }
+    }
+
+    // For a ramp kept in flash.
+    uint8_t at(uint32_t elapsedMs, uint32_t durationMs) const {
+        if (elapsedMs >= durationMs) return 0xFF;
+
+        const uint16_t position = elapsedMs * STEPS * 256 / durationMs;
+        const uint8_t from = pgm_read_byte(&shares[position >> 8]);
+        const uint8_t to = pgm_read_byte(&shares[(position >> 8) + 1]);
+        return from + (((to - from) * (position & 0xFF)) >> 8);
+    }
+};
+
+/**
+ * Servo moves are planned and stepped from react(), never waited for: each follows RAMP, taking
+ * MS_PER_DEGREE per degree of travel, and the angle is written when it changes, at most once per
+ * servo frame (the pulse is only refreshed that often anyway).
+ *
+ * `dispense` runs a DispenseProfile; `open` and `close` hold the servo open in between, for as
+ * long as the button is held. Once closed for the idle detach time (0: never) the servo is
+ * detached, which stops the Timer1 interrupt the Servo library otherwise takes every frame and
+ * allows power-down. The next move attaches it again at the angle it was left at.
+ */
+struct ServoRotator {
+    static constexpr LogLevel LOG_MODULE_LEVEL = LOG_LEVEL_SERVO;
+    static const uint8_t OPENED_DEGREES = 180;
+    static const uint8_t CLOSED_DEGREES = 0;
+    static const uint16_t DEFAULT_OPEN_TIME_MS = 2000;
+    static const uint16_t IDLE_DETACH_MS = 500;
+    static const uint8_t FRAME_MS = 20;
+    static const uint8_t MS_PER_DEGREE = 3;
+    static constexpr ProfileSection SECTION = PROFILE_SERVO;
+    static constexpr uint8_t WAKE_SOURCES = WAKE_KEEP_CLOCKS;
+    static constexpr uint32_t PERIOD_MS = FRAME_MS;
+
+    explicit ServoRotator(const int pin, uint16_t idleDetachMs = IDLE_DETACH_MS): _pin(pin), _idleDetachMs(idleDetachMs) {
+        attach();
     }
 
-    void open() {
-        _servo.write(OPENED_DEGREES);
-        state = BitWise.set(state, IS_OPEN, true);
+    void dispense(const DispenseProfile& profile) {
+        _profile = profile;
+        _repeatsLeft = profile.repeats;
+        moveTo(OPENING, profile.angle);
     }
 
-    template<typename TTimePeriodMs = uint16_t> void openTimed(TTimePeriodMs timePeriodMs = DEFAULT_OPEN_TIME_MS) {
-        open();
-        state = BitWise.set(state, IS_TIMED, true);
-        _openedTime = millis();
-        _closeTimePeriodMs =  timePeriodMs;
+    // Opens and stays open until `close`.
+    void open() { dispense(DispenseProfile{OPENED_DEGREES, 0, 0}); }
+
+    void openTimed(uint16_t timePeriodMs = DEFAULT_OPEN_TIME_MS) {
+        dispense(DispenseProfile{OPENED_DEGREES, 1, timePeriodMs});
     }
 
     void close() {
-        logger.info("closing");
-        state = BitWise.set(state, IS_OPEN, false);
-        state = BitWise.set(state, IS_TIMED, false);
-        _servo.write(CLOSED_DEGREES);
+        LOG_INFO("closing");
+        _repeatsLeft = 0;
+        moveTo(CLOSING, CLOSED_DEGREES);
     }
 
-    void react() override {
-        if (BitWise.get(state, IS_OPEN) && BitWise.get(state, IS_TIMED) && getMillisDiff(millis(), _openedTime) >= _closeTimePeriodMs) close();
+    void react() {
+        const auto nowMs = millis();
+        const auto elapsedMs = getMillisDiff(nowMs, _phaseAt);
+
+        switch (_phase) {
+            case OPENING:
+            case CLOSING:
+                if (elapsedMs < _moveMs && getMillisDiff(nowMs, _steppedAt) < FRAME_MS) return;
+                step(nowMs, elapsedMs);
+                if (elapsedMs >= _moveMs) endMove(nowMs);
+                return;
+            case DWELLING:
+                if (elapsedMs >= _profile.dwellMs) moveTo(CLOSING, CLOSED_DEGREES);
+                return;
+            case CLOSED:
+                if (_isAttached && _idleDetachMs && elapsedMs >= _idleDetachMs) detach();
+                return;
+            case HELD:
+                return;
+        }
     }
 
-private:
-    static const uint16_t DEFAULT_OPEN_TIME_MS = 2000;
-    static const uint8_t OPENED_DEGREES = 180;
-    static const uint8_t CLOSED_DEGREES = 0;
+    // Moving or holding needs the servo pulses, so the timers keep running until it is detached.
+    Wake nextWake() const {
+        const auto nowMs = millis();
+        const auto elapsedMs = getMillisDiff(nowMs, _phaseAt);
 
-    static const uint8_t IS_OPEN = 0b00000001;
-    static const uint8_t IS_TIMED = 0b00000010;
+        switch (_phase) {
+            case OPENING:
+            case CLOSING: {
+                const auto steppedMs = getMillisDiff(nowMs, _steppedAt);
+                return Wake{(uint32_t)(steppedMs >= FRAME_MS ? 0 : FRAME_MS - steppedMs), WAKE_KEEP_CLOCKS};
+            }
+            case DWELLING:
+                return Wake{(uint32_t)(elapsedMs >= _profile.dwellMs ? 0 : _profile.dwellMs - elapsedMs), WAKE_KEEP_CLOCKS};
+            case HELD:
+                return Wake{Wake::NEVER, WAKE_KEEP_CLOCKS};
+            case CLOSED:
+                if (!_isAttached || !_idleDetachMs) return Wake{Wake::NEVER};
+                return Wake{(uint32_t)(elapsedMs >= _idleDetachMs ? 0 : _idleDetachMs - elapsedMs), WAKE_KEEP_CLOCKS};
+        }
+        return Wake{};
+    }
 
-    Servo _servo;
-    uint8_t state = 0b00000000;
-    uint32_t _openedTime = 0;
-    uint32_t _closeTimePeriodMs = 0;
-};
+    enum Phase: uint8_t { CLOSED, OPENING, DWELLING, HELD, CLOSING };
 
-template<typename TContext, uint8_t BUFFER_SIZE>
-struct CommandInterpreter {
-    const struct CommandType {
-        const char* setTime = "sti";
-        const char* scheduleJob = "scj";
-        const char* getJobs = "gj";
-        const char* unscheduleJob = "usj";
-    } commands;
+    bool isAttached() const { return _isAttached; }
+    uint8_t angle() const { return _angle; }
+    Phase phase() const { return _phase; }
 
-    explicit CommandInterpreter(TContext& context): _context{context} {}
+private:
+
+    static constexpr ServoRamp<16> RAMP PROGMEM{};
 
-    CommandInterpreter& setOnSetTimeListener(void(*onSetTime)(uint32_t timeMs, TContext& context)) {
-        _onSetTime = onSetTime;
-        return *this;
+    Servo _servo;
+    const uint8_t _pin;
+    const uint16_t _idleDetachMs;
+    bool _isAttached = false;
+
+    Phase _phase = CLOSED;
+    uint32_t _phaseAt = 0;
+    uint32_t _steppedAt = 0;
+    uint16_t _moveMs = 0;
+    uint8_t _angle = CLOSED_DEGREES;
+    uint8_t _from = CLOSED_DEGREES;
+    uint8_t _to = CLOSED_DEGREES;
+
+    DispenseProfile _profile{OPENED_DEGREES, 0, 0};
+    uint8_t _repeatsLeft = 0;
+
+    // The angle is set first, so the first pulse after attaching already holds it.
+    void attach() {
+        _servo.write(_angle);
+        _servo.attach(_pin);
+        _isAttached = true;
+        _phaseAt = millis();
     }
 
-    CommandInterpreter& setOnScheduleJobListener(void(*onScheduleJob)(uint8_t hour, uint8_t minutes, uint8_t secs, TContext& context)) {
-        _onScheduleJob = onScheduleJob;
-        return *this;
+    void detach() {
+        _servo.detach();
+        _isAttached = false;
+        LOG_DEBUG("detached");
     }
 
-    CommandInterpreter& setOnGetJobsListener(void(*onGetJobs)(TContext& context)) {
-        _onGetJobs = onGetJobs;
-        return *this;
+    void moveTo(Phase phase, uint8_t angle) {
+        if (!_isAttached) attach();
+        _phase = phase;
+        _phaseAt = millis();
+        _steppedAt = _phaseAt - FRAME_MS;
+        _from = _angle;
+        _to = angle;
+        _moveMs = (_to > _from ? _to - _from : _from - _to) * MS_PER_DEGREE;
     }
 
-    CommandInterpreter& setOnUnscheduleJobListener(void(*onUnscheduleJob)(uint8_t id, TContext& context)) {
-        _onUnscheduleJob = onUnscheduleJob;
-        return *this;
+    void step(uint32_t nowMs, uint32_t elapsedMs) {
+        _steppedAt = nowMs;
+        const uint8_t share = RAMP.at(elapsedMs, _moveMs);
+        const auto angle = _to > _from
+                ? _from + (uint8_t)(((uint16_t)(_to - _from) * share + 127) / 255)
+                : _from - (uint8_t)(((uint16_t)(_from - _to) * share + 127) / 255);
+        if (angle == _angle) return;
+
+        _angle = angle;
+        _servo.write(_angle);
     }
-    static void split(char* input, uint8_t maxCount, char* output[]) {
-        input[BUFFER_SIZE - 1] = '\0';
+
+    void endMove(uint32_t nowMs) {
+        _phaseAt = nowMs;
+        if (_phase == OPENING) {
+            _phase = _repeatsLeft ? DWELLING : HELD;
+            return;
+        }
+
+        if (_repeatsLeft > 1) {
+            _repeatsLeft--;
+            moveTo(OPENING, _profile.angle);
+            return;
+        }
+        _repeatsLeft = 0;
+        _phase = CLOSED;
+    }
+};
+
+/**
+ * Dispatches text lines and binary frames through the command table of `TCommands` (see CommandTable.h).
+ */
+template<typename TContext, typename TCommands>
+struct CommandInterpreter {
+    typedef Command<TContext> Entry;
+    typedef CommandMatcher<TCommands> Matcher;
+
+    explicit CommandInterpreter(TContext& context): _context{context} {}
+
+    void interpret(const char* input, TContext& context) const {
+        LOG_INFO("command {}", input);
+
+        Tokenizer tokens(input);
+        Token name;
+        tokens.next(name);
+        const auto index = Matcher::find(name);
+        if (index < 0) {
+            LOG_DEBUG("command not matched");
+            return;
+        }
+
+        Entry command;
+        memcpy_P(&command, &TCommands::table[index], sizeof(Entry));
+
+        uint32_t args[COMMAND_MAX_ARGS]{};
         uint8_t count = 0;
-        output[count++] = input;
-        for (int16_t i = 0; i < BUFFER_SIZE; ++i) {
-            if (input[i] == ',') {
-                input[i] = '\0';
-                output[count++] = &input[i + 1];
-                if (count == maxCount) break;
+        Token arg;
+        while (tokens.next(arg)) {
+            if (count == command.arity || !arg.toUnsigned(Entry::maxOf(command.types[count]), args[count])) {
+                LOG_DEBUG("bad arguments");
+                return;
             }
+            count++;
+        }
+        if (count != command.arity) {
+            LOG_DEBUG("bad arguments");
+            return;
         }
+
+        if (command.handler(args, nullptr, context) != BinaryProtocol::OK) LOG_DEBUG("rejected");
     }
 
-    void interpret(const char* input, TContext& context) const {
-        char* argv[2]{};
-        char inputCopy[BUFFER_SIZE];
-        strncpy(inputCopy, input, BUFFER_SIZE);
-        split(inputCopy, 2, argv);
-
-        const char* command = argv[0];
-        char* payload = argv[1];
-
-        logger.info(command);
-
-        if (strcmp(command, commands.setTime) == 0) {
-            const auto timeMs = strtoul(payload, nullptr, 10);
-            onSetTime(timeMs);
-        } else if (strcmp(command, commands.scheduleJob) == 0) {
-            char* commandArgs[3];
-            split(payload, 3, commandArgs);
-            const uint8_t hour = strtol(commandArgs[0], nullptr, 10);
-            const uint8_t minutes = strtol(commandArgs[1], nullptr, 10);
-            const uint8_t secs = strtol(commandArgs[2], nullptr, 10);
-            onScheduleJob(hour, minutes, secs);
-        } else if (strcmp(command, commands.unscheduleJob) == 0) {
-            const uint8_t id = strtol(payload, nullptr, 10);
-            onUnscheduleJob(id);
-        } else if (strcmp(command, commands.getJobs) == 0) {
-            onGetJobs();
-        } else {
-            logger.debug("command not matched");
+    // Handles one binary frame as received between delimiters; it is decoded in place and answered on `reply`.
+    void interpretFrame(uint8_t* frame, uint8_t length, Print& reply) const {
+        const auto decodedLength = BinaryProtocol::decode(frame, length);
+        if (decodedLength < BinaryProtocol::HEADER_SIZE + BinaryProtocol::CRC_SIZE) {
+            CommandResponse(0, 0, BinaryProtocol::BAD_LENGTH).send(reply);
+            return;
         }
+
+        const uint8_t bodyLength = decodedLength - BinaryProtocol::CRC_SIZE;
+        CommandResponse response(frame[0], frame[1], BinaryProtocol::OK);
+        response.setStatus(dispatchFrame(frame, bodyLength, response));
+        response.send(reply);
     }
 
 private:
     TContext &_context;
 
-    void (*_onSetTime)(uint32_t, TContext &);
-    void onSetTime(uint32_t timeMs) const { if (_onSetTime) _onSetTime(timeMs, _context); }
+    uint8_t dispatchFrame(const uint8_t* frame, uint8_t bodyLength, CommandResponse& response) const {
+        if (FrameReader(frame + bodyLength, BinaryProtocol::CRC_SIZE).u16() != BinaryProtocol::crc16(frame, bodyLength)) {
+            return BinaryProtocol::BAD_CRC;
+        }
+
+        const auto index = Matcher::findOpcode(frame[0]);
+        if (index < 0) return BinaryProtocol::UNKNOWN_OPCODE;
 
-    void (*_onScheduleJob)(uint8_t hour, uint8_t minutes, uint8_t secs, TContext& context);
-    void onScheduleJob(uint8_t hour, uint8_t minutes, uint8_t secs) const { if(_onScheduleJob) _onScheduleJob(hour, minutes, secs, _context); }
+        Entry command;
+        memcpy_P(&command, &TCommands::table[index], sizeof(Entry));
 
-    void (*_onUnscheduleJob)(uint8_t id, TContext& context);
-    void onUnscheduleJob(uint8_t id) const { if(_onUnscheduleJob) _onUnscheduleJob(id, _context); }
+        FrameReader reader(frame + BinaryProtocol::HEADER_SIZE, bodyLength - BinaryProtocol::HEADER_SIZE);
+        uint32_t args[COMMAND_MAX_ARGS]{};
+        for (uint8_t i = 0; i < command.arity; ++i) {
+            switch (command.types[i]) {
+                case Entry::U8: args[i] = reader.u8(); break;
+                case Entry::U16: args[i] = reader.u16(); break;
+                case Entry::U32: args[i] = reader.u32(); break;
+            }
+        }
+        if (!reader.isValid() || reader.remaining()) return BinaryProtocol::BAD_LENGTH;
 
-    void (*_onGetJobs)(TContext &);
-    void onGetJobs() const { if(_onGetJobs) _onGetJobs(_context); }
+        return command.handler(args, &response, _context);
+    }
 };
 
 struct Program {
     DayJob<Program> testJob{
         Time::fromMs(Time::now().toMs() + 5000),
-        [](Program& program){ program.redLed.turnOn(); },
+        [](Program& program, const DayJob<Program>&){ program.redLed.turnOn(); },
         true
     };
-    StreamListener<Program, 20> streamListener{
+    StreamListener<Program, 32> streamListener{
         *this,
         Serial,
         [](const char* input, Program& program) {
             program.commandInterpreter.interpret(input, program);
         },
+        "\r\n",
+        [](uint8_t* frame, uint8_t length, Program& program) {
+            program.commandInterpreter.interpretFrame(frame, length, Serial);
+        },
     };
     const Led redLed{13};
     ServoRotator servoRotator{9};
+    static constexpr uint8_t BUTTON_PIN = 2;
     Button<Program> rotatorButton{
-            2,
+            BUTTON_PIN,
             *this,
             [](Program &program) {
-                logger.debug("clicked");
+                LOG_DEBUG("clicked");
                 program.redLed.toggle();
                 program.servoRotator.openTimed();
                 // Time::set(Time::fromMs(1641669327069)); // 19:15:28
-                if (program.jobsScheduler.schedule(&program.testJob)) logger.info("scheduled");
+                if (program.jobsScheduler.schedule(&program.testJob)) LOG_INFO("scheduled");
             },
             [](Program &program) {
-                logger.debug("held");
+                LOG_DEBUG("held");
                 program.redLed.turnOn();
                 program.servoRotator.open();
-                if (program.jobsScheduler.unschedule(&program.testJob)) logger.info("unscheduled");
+                if (program.jobsScheduler.unschedule(&program.testJob)) LOG_INFO("unscheduled");
             },
             [](Program &program) {
-                logger.debug("released");
+                LOG_DEBUG("released");
                 program.redLed.turnOff();
                 program.servoRotator.close();
             }
     };
-    DayJobsScheduler<Program> jobsScheduler{*this};
-    CommandInterpreter<Program, 20> commandInterpreter = CommandInterpreter<Program, 20>{*this}
-            .setOnSetTimeListener([](uint32_t timeMs, Program &context) {
-                Time::set(Time::fromMs(timeMs));
-            })
-            .setOnScheduleJobListener([](uint8_t hour, uint8_t minutes, uint8_t secs, Program &context) {
-                context.jobsScheduler.schedule(new DayJob<Program>{
-                        Time().setHours(hour).setMinutes(minutes).setSeconds(secs),
-                        [](Program &program) {
-                            program.servoRotator.openTimed(1000);
-                        }
-                });
-            })
-            .setOnGetJobsListener([](Program& context){
-                const auto jobs = context.jobsScheduler.getJobs();
-                for (int i = 0; i < jobs.count; ++i) {
-                    const auto currentJob = jobs.at(i);
-                    logger.debug(i);
-                    logger.debug(currentJob->isSystem ? "system job" : "user job");
-                    logger.debug("");
-                }
-
-                if (!jobs.count) { logger.debug("no jobs scheduled"); }
-            })
-            .setOnUnscheduleJobListener([](uint8_t id, Program& context){
-                logger.debug(context.jobsScheduler.unscheduleAndFree(id) ? "unscheduled" : "failed to unschedule");
-            });
-
+    typedef DayJobsScheduler<Program, SCHEDULER_JOBS> JobsScheduler;
+    typedef ScheduleStore<Program, JobsScheduler::MAX_JOBS> Store;
+    typedef ScheduleUpload<Program, JobsScheduler::MAX_JOBS> Upload;
+
+    JobsScheduler jobsScheduler{*this};
+    // user jobs from `scj`; their handles are the job ids on the serial interface
+    Pool<DayJob<Program>, JobsScheduler::MAX_JOBS> userJobs;
+    // by pool slot
+    DispenseProfile jobProfiles[JobsScheduler::MAX_JOBS]{};
+    Store store{*this};
+    Upload scheduleUpload;
+    ClockSync clockSync;
+    struct Commands;
+    CommandInterpreter<Program, Commands> commandInterpreter{*this};
 
     Program() {
         Serial.begin(9600);
+        inputTrace.snapshot(Serial);
+        store.restore();
+    }
+
+    static constexpr DispenseProfile DEFAULT_PROFILE{ServoRotator::OPENED_DEGREES, 1, 1000};
+
+    // The task of every user job: its dispense profile.
+    static void feed(Program& program, const DayJob<Program>& job) {
+        program.servoRotator.dispense(program.jobProfiles[program.userJobs.handleOf(&job) & 0xFF]);
     }
 
+    // in the order they run in a pass
+    typedef ComponentList<
+            &Program::rotatorButton,
+            &Program::servoRotator,
+            &Program::jobsScheduler,
+            &Program::store,
+            &Program::streamListener
+    > Components;
+
+    // Sleep::until can only power down for a pin change through the pin's external interrupt, and
+    // only the watchdog times a power-down, 16 ms at the least: a shorter period needs the clocks
+    static_assert(!(Components::WAKE_SOURCES & WAKE_PIN_CHANGE) || digitalPinToInterrupt(BUTTON_PIN) != NOT_AN_INTERRUPT,
+                  "the button must be on a pin with an external interrupt");
+    static_assert(Components::PERIOD_MS >= Sleep::WATCHDOG_PERIOD_MS || (Components::WAKE_SOURCES & WAKE_KEEP_CLOCKS),
+                  "a period shorter than a watchdog sleep must keep the clocks running");
+
     void act() {
-        rotatorButton.react();
-        servoRotator.react();
-        jobsScheduler.react();
-        streamListener.react();
-        auto time = Time::now();
-        String res;
-        res.concat(time.hours);
-        res.concat(":");
-        res.concat(time.minutes);
-        res.concat(":");
-        res.concat(time.seconds);
-        static String x;
-        if (x != res) {
-            x = res;
-            logger.debug(res.c_str());
+        const auto startUs = profiler.start();
+        Components::react(*this);
+        // the clock line exists only for the debug log, so it is not even built below that level; it
+        // goes out when the second changes, as ms the decoder shows as HH:MM:SS
+        if constexpr (LOG_MODULE_LEVEL >= LOG_LEVEL_DEBUG) profiler.measure(PROFILE_CLOCK, [] {
+            // start of the second last logged, one second back at boot so the first pass logs
+            static uint32_t secondMs = (uint32_t)0 - 1000;
+            const auto nowMs = Time::nowMs();
+            if (nowMs - secondMs < 1000) return;
+            secondMs = nowMs - nowMs % 1000;
+            LOG_DEBUG("clock {t}", secondMs);
+        });
+        profiler.measure(PROFILE_OUTPUT, [] {
+            logger.drain(Serial);
+            inputTrace.drain(Serial);
+        });
+        profiler.stop(PROFILE_ACT, startUs);
+    }
+
+    // Sleeps until the earliest component deadline or a watched input; pending log records keep
+    // the CPU in idle so the serial port can take them, while a host has it open. Without one the
+    // port takes nothing: they wait, and new ones are dropped, rather than keep it from power-down.
+    void idle() const {
+        Sleep::clearInput();
+        auto wake = Components::nextWake(*this);
+        if ((logger.used() || logger.dropped || inputTrace.isPending()) && isHostListening()) {
+            wake = wake.earliest(Wake{1, WAKE_KEEP_CLOCKS});
         }
+        Sleep::until(wake);
     }
+
+    static bool isHostListening() {
+#ifdef USBCON
+        return USBDevice.configured() && Serial.dtr();
+#else
+        return true;
+#endif
+    }
+};
+
+/**
+ * Static footprint of the firmware's parts as this build lays them out, for `mem` and the build
+ * summary of scripts/memory_report.sh, which reads the table out of the ELF by its symbol. Program
+ * is allocated on the heap at boot; the log, trace and profiler buffers are globals in .bss.
+ */
+struct Footprint {
+    char name[8];
+    uint16_t size;
+};
+
+extern const Footprint memoryFootprint[] PROGMEM;
+__attribute__((used)) const Footprint memoryFootprint[] PROGMEM = {
+        {"Program", sizeof(Program)},
+        {"Button", sizeof(Program::rotatorButton)},
+        {"Servo", sizeof(Program::servoRotator)},
+        {"Sched", sizeof(Program::jobsScheduler)},
+        {"Jobs", sizeof(Program::userJobs)},
+        {"Store", sizeof(Program::store)},
+        {"Upload", sizeof(Program::scheduleUpload)},
+        {"Sync", sizeof(Program::clockSync)},
+        {"Stream", sizeof(Program::streamListener)},
+        {"Command", sizeof(Program::commandInterpreter)},
+        {"Logger", sizeof(logger)},
+        {"Trace", sizeof(inputTrace)},
+        {"Profile", sizeof(profiler)},
+};
+static const uint8_t FOOTPRINT_ENTRIES = sizeof(memoryFootprint) / sizeof(memoryFootprint[0]);
+
+// a full job list and an export page with its header and a record in a response frame
+static_assert(3 + 1 + Program::JobsScheduler::MAX_JOBS * 7 + BinaryProtocol::CRC_SIZE <= COMMAND_RESPONSE_SIZE,
+              "responses must hold the list of a full scheduler");
+static_assert(StateExport<Program>::RECORDS_PER_PAGE >= 1, "responses must hold an export page");
+
+struct Program::Commands {
+    typedef Command<Program> Entry;
+
+    static constexpr Entry table[] PROGMEM = {
+            {"sti", BinaryProtocol::SET_TIME, 1, {Entry::U32}, [](const uint32_t* args, CommandResponse* response, Program& context) -> uint8_t {
+                if (args[0] >= Time::DAY_MS) return BinaryProtocol::REJECTED;
+                Time::set(Time(args[0]));
+                context.store.saveClock();
+                return BinaryProtocol::OK;
+            }},
+            {"scj", BinaryProtocol::SCHEDULE_JOB, 3, {Entry::U8, Entry::U8, Entry::U8}, [](const uint32_t* args, CommandResponse* response, Program& context) -> uint8_t {
+                if (args[0] > 23 || args[1] > 59 || args[2] > 59) return BinaryProtocol::REJECTED;
+
+                const auto handle = context.userJobs.create(Time::of(args[0], args[1], args[2]), Program::feed);
+                if (!handle) return BinaryProtocol::REJECTED;
+                if (!context.jobsScheduler.schedule(context.userJobs.get(handle))) {
+                    context.userJobs.destroy(handle);
+                    return BinaryProtocol::REJECTED;
+                }
+                context.jobProfiles[handle & 0xFF] = DEFAULT_PROFILE;
+                context.store.saveJob(handle);
+                LOG_DEBUG("job {} scheduled", handle);
+                if (response) response->u16(handle);
+                return BinaryProtocol::OK;
+            }},
+            {"usj", BinaryProtocol::UNSCHEDULE_JOB, 1, {Entry::U16}, [](const uint32_t* args, CommandResponse* response, Program& context) -> uint8_t {
+                const auto job = context.userJobs.get(args[0]);
+                if (!job) {
+                    LOG_DEBUG("no job {}", args[0]);
+                    return BinaryProtocol::REJECTED;
+                }
+
+                context.jobsScheduler.unschedule(job);
+                context.userJobs.destroy(args[0]);
+                context.store.saveJob(args[0]);
+                LOG_DEBUG("unscheduled");
+                return BinaryProtocol::OK;
+            }},
+            {"sjp", BinaryProtocol::SET_JOB_PROFILE, 4, {Entry::U16, Entry::U8, Entry::U16, Entry::U8}, [](const uint32_t* args, CommandResponse* response, Program& context) -> uint8_t {
+                const DispenseProfile profile{(uint8_t)args[1], (uint8_t)args[3], (uint16_t)args[2]};
+                if (!context.userJobs.get(args[0]) || !profile.isValid()) return BinaryProtocol::REJECTED;
+
+                context.jobProfiles[args[0] & 0xFF] = profile;
+                context.store.saveJob(args[0]);
+                return BinaryProtocol::OK;
+            }},
+            {"sjr", BinaryProtocol::SET_JOB_RULE, 4, {Entry::U16, Entry::U8, Entry::U16, Entry::U16}, [](const uint32_t* args, CommandResponse* response, Program& context) -> uint8_t {
+                const auto job = context.userJobs.get(args[0]);
+                // what does not fit the rule's fields would be stored as another rule
+                if (!job || args[1] > Recurrence::EVERY_DAY || args[2] > Recurrence::MAX_MINUTE || args[3] > Recurrence::MAX_MINUTE) {
+                    return BinaryProtocol::REJECTED;
+                }
+                const Recurrence rule{(uint8_t)args[1], (uint16_t)args[2], (uint16_t)args[3]};
+                if (!context.jobsScheduler.reschedule(job, rule)) return BinaryProtocol::REJECTED;
+
+                context.store.saveJob(args[0]);
+                return BinaryProtocol::OK;
+            }},
+            {"sbb", BinaryProtocol::BEGIN_SCHEDULE, 0, {}, [](const uint32_t* args, CommandResponse* response, Program& context) -> uint8_t {
+                context.scheduleUpload.begin();
+                return BinaryProtocol::OK;
+            }},
+            {"sbj", BinaryProtocol::STAGE_JOB, 3, {Entry::U32, Entry::U32, Entry::U32}, [](const uint32_t* args, CommandResponse* response, Program& context) -> uint8_t {
+                return context.scheduleUpload.stage(args[0], args[1], args[2]);
+            }},
+            {"sbc", BinaryProtocol::COMMIT_SCHEDULE, 1, {Entry::U8}, [](const uint32_t* args, CommandResponse* response, Program& context) -> uint8_t {
+                const auto status = context.scheduleUpload.commit(context, args[0]);
+                if (status != BinaryProtocol::OK) return status;
+
+                const auto checksum = Upload::checksum(context);
+                if (response) response->u8(args[0]).u16(checksum);
+                else LOG_INFO("schedule of {} jobs committed, checksum {04x}", args[0], checksum);
+                return BinaryProtocol::OK;
+            }},
+            {"swd", BinaryProtocol::SET_WEEKDAY, 1, {Entry::U8}, [](const uint32_t* args, CommandResponse* response, Program& context) -> uint8_t {
+                if (args[0] > 6) return BinaryProtocol::REJECTED;
+                Time::setWeekday(args[0]);
+                context.store.saveClock();
+                return BinaryProtocol::OK;
+            }},
+            {"gj", BinaryProtocol::LIST_JOBS, 0, {}, [](const uint32_t* args, CommandResponse* response, Program& context) -> uint8_t {
+                const auto& jobs = context.jobsScheduler.getJobs();
+                if (response) {
+                    response->u8(jobs.size());
+                    for (const auto job : jobs) {
+                        response->u16(context.userJobs.handleOf(job)).u32(job->time.toMs()).u8(job->isSystem | !job->rule.isDaily() << 1);
+                    }
+                    return BinaryProtocol::OK;
+                }
+
+                for (const auto currentJob : jobs) {
+                    if (currentJob->isSystem) LOG_DEBUG("job at {t}: system job", currentJob->time.toMs());
+                    else LOG_DEBUG("job {} at {t}: user job", context.userJobs.handleOf(currentJob), currentJob->time.toMs());
+                }
+
+                if (jobs.isEmpty()) { LOG_DEBUG("no jobs scheduled"); }
+                return BinaryProtocol::OK;
+            }},
+            {"exp", BinaryProtocol::EXPORT_STATE, 2, {Entry::U8, Entry::U16}, [](const uint32_t* args, CommandResponse* response, Program& context) -> uint8_t {
+                if (args[0] > context.jobsScheduler.getJobs().size()) return BinaryProtocol::REJECTED;
+
+                if (response) StateExport<Program>::page(context, args[0], args[1], *response);
+                else StateExport<Program>::log(context, args[1]);
+                return BinaryProtocol::OK;
+            }},
+            {"syn", BinaryProtocol::SYNC_TIME, 1, {Entry::U32}, [](const uint32_t* args, CommandResponse* response, Program& context) -> uint8_t {
+                if (args[0] >= Time::DAY_MS) return BinaryProtocol::REJECTED;
+
+                const auto deviceMs = context.clockSync.request(args[0]);
+                if (response) response->u32(deviceMs);
+                else LOG_INFO("sync: feeder at {t}", deviceMs);
+                return BinaryProtocol::OK;
+            }},
+            {"sya", BinaryProtocol::SYNC_ADJUST, 1, {Entry::U32}, [](const uint32_t* args, CommandResponse* response, Program& context) -> uint8_t {
+                ClockSync::Result result{};
+                if (args[0] >= Time::DAY_MS || !context.clockSync.adjust(args[0], result)) return BinaryProtocol::REJECTED;
+
+                if (result.isStepped) context.store.saveClock();
+                context.store.saveRate();
+
+                const auto ratePpm100 = ClockSync::ratePpm100();
+                if (response) response->u16(result.rttMs).u32(result.offsetMs).u32(ratePpm100);
+                else LOG_INFO("sync: round trip {} ms, offset {} ms, rate {.2} ppm", result.rttMs, result.offsetMs, ratePpm100);
+                return BinaryProtocol::OK;
+            }},
+            {"mem", BinaryProtocol::READ_MEMORY, 0, {}, [](const uint32_t* args, CommandResponse* response, Program& context) -> uint8_t {
+                if (response) {
+                    response->u16(Memory::unusedStack()).u16(Memory::freeNow()).u16(Memory::freeHeap())
+                            .u16(Memory::largestFreeBlock()).u8(FOOTPRINT_ENTRIES);
+                    for (uint8_t i = 0; i < FOOTPRINT_ENTRIES; ++i) response->u16(pgm_read_word(&memoryFootprint[i].size));
+                    return BinaryProtocol::OK;
+                }
+
+                // the whole table would not fit the log buffer in one pass; frames get it
+                LOG_INFO("memory: {} B never reached by the stack, {} B free now", Memory::unusedStack(), Memory::freeNow());
+                LOG_INFO("heap: {} B free, {} B largest block, Program {} B", Memory::freeHeap(), Memory::largestFreeBlock(),
+                         (uint16_t)sizeof(Program));
+                return BinaryProtocol::OK;
+            }},
+            {"ser", BinaryProtocol::READ_SERIAL, 0, {}, [](const uint32_t* args, CommandResponse* response, Program& context) -> uint8_t {
+                const auto& listener = context.streamListener;
+                if (response) {
+                    response->u32(listener.lines).u32(listener.frames).u16(listener.linesTruncated).u16(listener.framesOverflowed);
+                } else {
+                    LOG_INFO("serial: {} lines, {} frames; dropped too long: {} lines, {} frames", listener.lines,
+                             listener.frames, listener.linesTruncated, listener.framesOverflowed);
+                }
+                return BinaryProtocol::OK;
+            }},
+#if PROFILER
+            {"prf", BinaryProtocol::READ_PROFILE, 1, {Entry::U8}, [](const uint32_t* args, CommandResponse* response, Program& context) -> uint8_t {
+                if (args[0] >= PROFILE_SECTIONS) return BinaryProtocol::REJECTED;
+
+                const auto& stats = profiler.stats(args[0]);
+                if (response) {
+                    response->u8(PROFILE_SECTIONS).u32(stats.count).u32(stats.totalUs).u16(stats.maxUs);
+                    for (const auto count : stats.histogram) response->u16(count);
+                } else {
+                    LOG_INFO("profile {}: {} calls, {} us, {} us max", args[0], stats.count, stats.totalUs, stats.maxUs);
+                    for (uint8_t bucket = 0; bucket < Profiler<PROFILE_SECTIONS>::BUCKETS; ++bucket) {
+                        if (stats.histogram[bucket]) {
+                            LOG_INFO("profile {}: {} from {} us", args[0], stats.histogram[bucket], Profiler<PROFILE_SECTIONS>::bucketStartUs(bucket));
+                        }
+                    }
+                }
+                profiler.reset(args[0]);
+                return BinaryProtocol::OK;
+            }},
+#endif
+    };
 };
 
 Program* program;
 
+#if AVR_BENCH
+// cycle counts on the AVR instead of the feeder (see Benchmarks.h)
+#include "Benchmarks.h"
+#else
 __attribute__((unused)) void setup() { program = new Program(); }
-__attribute__((unused)) void loop() { program->act(); }
+__attribute__((unused)) void loop() {
+    program->act();
+    program->idle();
+}
+#endif